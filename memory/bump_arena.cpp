@@ -0,0 +1,131 @@
+#include "bump_arena.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <new>
+
+namespace {
+    char* align_up(char* p, size_t alignment) {
+        uintptr_t v = reinterpret_cast<uintptr_t>(p);
+        return reinterpret_cast<char*>((v + alignment - 1) & ~(uintptr_t{alignment} - 1));
+    }
+}
+
+BumpArena::BumpArena(MemoryPool* pool, size_t block_size, size_t max_retained)
+    : pool_(pool != nullptr ? pool : &MemoryPool::get_instance())
+    , block_size_(std::min(std::max<size_t>(block_size, 1), pool_->max_chunk_size()))
+    , max_retained_(max_retained) {
+}
+
+BumpArena::~BumpArena() {
+    release();
+}
+
+void* BumpArena::alloc(size_t bytes, size_t alignment) {
+    if (bytes == 0) bytes = 1;
+    if (alignment == 0 || (alignment & (alignment - 1)) != 0) throw std::bad_alloc();
+
+    // 快路径：当前块内递增
+    if (cursor_ != nullptr) {
+        char* start = align_up(cursor_, alignment);
+        if (start <= end_ && static_cast<size_t>(end_ - start) >= bytes) {
+            used_ += static_cast<size_t>(start + bytes - cursor_);
+            cursor_ = start + bytes;
+            return start;
+        }
+    }
+    return alloc_slow(bytes, alignment);
+}
+
+void* BumpArena::alloc_slow(size_t bytes, size_t alignment) {
+    // 超大请求：单独分配一个块，不进入复用链表，当前块的游标保持不变
+    size_t need = bytes + alignment - 1;
+    if (need > block_size_) {
+        Chunk* chunk = nullptr;
+        try {
+            chunk = need > pool_->max_chunk_size() ? new Chunk(need) : pool_->alloc_chunk(need);
+        } catch (const std::exception&) {
+            throw std::bad_alloc();
+        }
+        if (chunk == nullptr) throw std::bad_alloc();
+        chunk->next = oversize_;
+        oversize_ = chunk;
+        used_ += need;
+        return align_up(chunk->data, alignment);
+    }
+
+    // 换到链表中的下一个块（上一轮留下的），没有则向内存池申请
+    Chunk* next = current_ != nullptr ? current_->next : head_;
+    if (next == nullptr) {
+        try {
+            next = pool_->alloc_chunk(block_size_);
+        } catch (const std::exception&) {
+            throw std::bad_alloc();
+        }
+        if (next == nullptr) throw std::bad_alloc();
+        retained_ += next->capacity;
+        if (current_ != nullptr) {
+            current_->next = next;
+        } else {
+            head_ = next;
+        }
+    }
+    current_ = next;
+    cursor_ = next->data;
+    end_ = next->data + next->capacity;
+    return alloc(bytes, alignment);
+}
+
+void BumpArena::free_chunk(Chunk* chunk) {
+    chunk->next = nullptr;
+    if (chunk->capacity > pool_->max_chunk_size()) {
+        delete chunk;
+    } else {
+        pool_->retrieve(chunk);
+    }
+}
+
+// 保留的块超过上限时，从链尾一侧归还（只保留前面的块）
+void BumpArena::trim_retained() {
+    size_t kept = head_->capacity;
+    Chunk* c = head_;
+    while (c->next != nullptr && kept + c->next->capacity <= max_retained_) {
+        c = c->next;
+        kept += c->capacity;
+    }
+    Chunk* extra = c->next;
+    c->next = nullptr;
+    while (extra != nullptr) {
+        Chunk* next = extra->next;
+        free_chunk(extra);
+        extra = next;
+    }
+    retained_ = kept;
+}
+
+void BumpArena::reset() {
+    while (oversize_ != nullptr) {
+        Chunk* next = oversize_->next;
+        free_chunk(oversize_);
+        oversize_ = next;
+    }
+
+    // 块内没有逐块状态：只需把游标拨回链头之前
+    current_ = nullptr;
+    cursor_ = nullptr;
+    end_ = nullptr;
+    used_ = 0;
+
+    if (retained_ > max_retained_ && head_ != nullptr) {
+        trim_retained();
+    }
+}
+
+void BumpArena::release() {
+    reset();
+    while (head_ != nullptr) {
+        Chunk* next = head_->next;
+        free_chunk(head_);
+        head_ = next;
+    }
+    retained_ = 0;
+}
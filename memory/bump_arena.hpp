@@ -0,0 +1,66 @@
+#ifndef BUMP_ARENA_HPP
+#define BUMP_ARENA_HPP
+
+#include <cstddef>
+#include <memory_resource>
+#include "chunk.hpp"
+#include "memory_pool.hpp"
+
+// BumpArena：指针递增分配区，数据区由内存池的块串成链表（经Chunk::next串联）
+// 这是库中唯一的单调分配区：既直接按指针分配（alloc），也作为std::pmr::memory_resource供pmr容器使用
+// 分配只移动当前块内的游标；reset()把游标拨回第一个块、已申请的块留作下次复用，
+// 只有一个游标而没有逐块状态，因此reset()为O(1)（本轮的超大块与超出保留上限的块在此时归还，按分配次数摊还）
+// 区内对象的析构函数不会被调用：只放平凡析构的对象，或在reset()之前自行析构（如std::pmr容器）
+// 非线程安全：同一时刻只能由一个线程使用（如所属连接的IO线程）
+class BumpArena : public std::pmr::memory_resource {
+public:
+    static constexpr size_t DEFAULT_BLOCK_SIZE = 4096;             // 每次向内存池申请的块大小
+    static constexpr size_t DEFAULT_MAX_RETAINED = 64 * 1024;      // reset()后保留复用的块总字节数上限
+
+    // pool为nullptr时使用全局单例内存池
+    explicit BumpArena(MemoryPool* pool = nullptr,
+                       size_t block_size = DEFAULT_BLOCK_SIZE,
+                       size_t max_retained = DEFAULT_MAX_RETAINED);
+    ~BumpArena() override;
+
+    BumpArena(const BumpArena&) = delete;
+    BumpArena& operator=(const BumpArena&) = delete;
+
+    // 分配bytes字节（按alignment对齐），内存池分配失败时抛出std::bad_alloc
+    void* alloc(size_t bytes, size_t alignment = alignof(std::max_align_t));
+
+    // 丢弃全部分配：游标回到第一个块，超出max_retained的块与超大块归还内存池
+    void reset();
+    // 归还全部块
+    void release();
+
+    // 供std::pmr容器使用的分配资源
+    std::pmr::memory_resource* resource() noexcept { return this; }
+    MemoryPool* pool() const noexcept { return pool_; }
+
+    size_t used_bytes() const { return used_; }          // 自上次reset()以来分配的字节数（含对齐填充）
+    size_t retained_bytes() const { return retained_; }  // 当前持有的块总字节数（不含超大块）
+
+private:
+    void* do_allocate(size_t bytes, size_t alignment) override { return alloc(bytes, alignment); }
+    void do_deallocate(void*, size_t, size_t) override {}  // 单个释放不做任何事，由reset()统一回收
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+    void* alloc_slow(size_t bytes, size_t alignment);
+    void free_chunk(Chunk* chunk);
+    void trim_retained();
+
+    MemoryPool* pool_;
+    size_t block_size_;
+    size_t max_retained_;
+
+    Chunk* head_{nullptr};     // 块链表头（reset后从这里重新开始）
+    Chunk* current_{nullptr};  // 当前分配所在的块，其后的块都未使用
+    Chunk* oversize_{nullptr}; // 超过块大小的单独分配（每次reset()归还）
+    char* cursor_{nullptr};    // 当前块内下一次分配的起点
+    char* end_{nullptr};       // 当前块数据区末尾
+    size_t used_{0};
+    size_t retained_{0};
+};
+
+#endif // BUMP_ARENA_HPP
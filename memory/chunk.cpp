@@ -1,4 +1,5 @@
 #include "chunk.hpp"
+#include "poison.hpp"
 #include <cstring>  
 #include <cassert>  
 #include <algorithm> 
@@ -10,11 +11,40 @@ Chunk::Chunk(size_t cap)
     : capacity(cap)      
     , length(0)           
     , head(0)             
-    , data(new char[cap]())  // 分配cap字节内存并初始化为0（ ()保证零初始化）
-    , next(nullptr) {    
+    , data(new char[cap])  // 分配cap字节内存，不做零初始化（避免构造时触碰所有物理页）
+    , next(nullptr)
+    , owns_data(true)
+    , file_fd(-1)
+    , block(nullptr) {
     assert(cap > 0);      // 调试期断言：容量必须大于0，防止创建空内存块
 }
 
+// Chunk构造函数 - 使用外部数据区（如slab中的槽位），析构时不释放
+Chunk::Chunk(char* buf, size_t cap)
+    : capacity(cap)
+    , length(0)
+    , head(0)
+    , data(buf)
+    , next(nullptr)
+    , owns_data(false)
+    , file_fd(-1)
+    , block(nullptr) {
+    assert(buf != nullptr && cap > 0);
+}
+
+// Chunk构造函数 - 文件区间节点：没有数据区，capacity = head + length，链尾剩余空间恒为0
+Chunk::Chunk(int fd, size_t offset, size_t len)
+    : capacity(offset + len)
+    , length(len)
+    , head(offset)
+    , data(nullptr)
+    , next(nullptr)
+    , owns_data(false)
+    , file_fd(fd)
+    , block(nullptr) {
+    assert(fd >= 0 && len > 0);
+}
+
 // Chunk移动构造函数（ noexcept 保证不抛出异常）
 Chunk::Chunk(Chunk&& other) noexcept
     // 直接接管other的所有资源
@@ -22,13 +52,18 @@ Chunk::Chunk(Chunk&& other) noexcept
     , length(other.length)
     , head(other.head)
     , data(other.data)
-    , next(other.next) {
+    , next(other.next)
+    , owns_data(other.owns_data)
+    , file_fd(other.file_fd)
+    , block(other.block) {
     // 重置源对象，防止其析构时释放已转移的资源
     other.capacity = 0;
     other.length = 0;
     other.head = 0;
     other.data = nullptr; // 源对象不再持有内存指针
     other.next = nullptr;
+    other.file_fd = -1;
+    other.block = nullptr;
 }
 
 // Chunk移动赋值运算符（ noexcept 保证不抛出异常）
@@ -36,7 +71,10 @@ Chunk& Chunk::operator=(Chunk&& other) noexcept {
     // 防止自赋值（移动自身无意义，且会导致资源释放）
     if (this != &other) {
         // 第一步：释放当前对象持有的内存资源，避免内存泄漏
-        delete[] data;
+        if (owns_data) {
+            poison_on_release(data, capacity);
+            delete[] data;
+        }
         
         // 第二步：接管other的所有资源
         capacity = other.capacity;
@@ -44,6 +82,9 @@ Chunk& Chunk::operator=(Chunk&& other) noexcept {
         head = other.head;
         data = other.data;
         next = other.next;
+        owns_data = other.owns_data;
+        file_fd = other.file_fd;
+        block = other.block;
         
         // 第三步：重置源对象，防止其析构时释放已转移的资源
         other.capacity = 0;
@@ -51,13 +92,19 @@ Chunk& Chunk::operator=(Chunk&& other) noexcept {
         other.head = 0;
         other.data = nullptr;
         other.next = nullptr;
+        other.file_fd = -1;
+        other.block = nullptr;
     }
     return *this;
 }
 
 // Chunk析构函数
 Chunk::~Chunk() {
-    delete[] data;  // 释放char数组（匹配构造函数的new char[]）
+    // 释放char数组（匹配构造函数的new char[]），外部数据区不释放
+    if (owns_data) {
+        poison_on_release(data, capacity);
+        delete[] data;
+    }
     data = nullptr; // 置空指针，避免野指针（防御性编程）
 }
 
@@ -134,19 +181,24 @@ bool Chunk::expand_capacity(size_t new_capacity) {
     }
     
     try {
-        // 分配新的内存块并初始化为0
-        char* new_data = new char[new_capacity]();
+        // 分配新的内存块（不做零初始化，有效数据之后的部分由调用方写入）
+        char* new_data = new char[new_capacity];
         
         // 复制现有有效数据到新内存块起始位置
         if (length > 0) {
             std::memcpy(new_data, data + head, length);
         }
+        poison_on_alloc(new_data + length, new_capacity - length);
         
-        // 释放旧内存块，避免内存泄漏
-        delete[] data;
+        // 释放旧内存块，避免内存泄漏（外部数据区由其所有者管理）
+        if (owns_data) {
+            poison_on_release(data, capacity);
+            delete[] data;
+        }
         
         // 更新指针和状态：新内存块、重置头部偏移、更新容量
         data = new_data;
+        owns_data = true;
         head = 0;          // 扩展后数据移到起始位置，偏移置0
         capacity = new_capacity;
         
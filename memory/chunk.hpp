@@ -3,14 +3,21 @@
 
 #include <cstddef>
 
+class SharedBlock;
+
 struct Chunk {
     size_t capacity;
     size_t length;
     size_t head;
     char* data;
     Chunk* next;
+    bool owns_data;    // data是否由本Chunk分配并负责释放（slab承载的块为false）
+    int file_fd;       // >=0表示本块是文件区间节点：数据留在文件中（head为文件偏移），发送时走sendfile
+    SharedBlock* block;  // 非空表示本块是共享块的只读视图（数据区属于block，不归还内存池）
 
     explicit Chunk(size_t cap);
+    Chunk(char* buf, size_t cap);  // 使用外部提供的数据区（不负责释放）
+    Chunk(int fd, size_t offset, size_t len);  // 文件区间[offset, offset+len)（不持有fd，由使用者负责关闭）
     Chunk(Chunk&& other) noexcept;
     Chunk& operator=(Chunk&& other) noexcept;
 
@@ -1,31 +1,54 @@
 #include <sys/ioctl.h>
+#include <sys/uio.h>
+#include <sys/sendfile.h>
+#include <fcntl.h>
 #include <unistd.h>
 #include <cstring>
 #include <cassert>
 #include <cerrno>
+#include <climits>
 #include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <endian.h>
 #include "data_buf.hpp"
-#include <limits>
 
 
-namespace {
-    bool safe_int_to_size(int value, size_t& result) {
-        if (value < 0) {
-            return false;
-        }
-        result = static_cast<size_t>(value);
-        return true;
+BufferBase::BufferBase(MemoryPool* pool, MemoryAccount* account)
+    : pool_(pool != nullptr ? pool : &MemoryPool::get_instance())
+    , account_(account) {
+}
+
+// 释放链上的单个节点：共享块视图节点释放引用，文件区间节点关闭其fd，普通块撤销计费后归还内存池
+void BufferBase::release_chunk(Chunk* chunk) {
+    chunk->next = nullptr;
+    if (chunk->file_fd >= 0) {
+        ::close(chunk->file_fd);
+        delete chunk;
+        return;
     }
-    
-    bool safe_add(size_t a, size_t b, size_t& result) {
-        if (a > std::numeric_limits<size_t>::max() - b) {
-            return false;
-        }
-        result = a + b;
-        return true;
+    if (chunk->block != nullptr) {
+        SharedBlock* block = chunk->block;
+        delete chunk;
+        block->release();
+        return;
+    }
+    if (account_ != nullptr) account_->uncharge(chunk->capacity);
+    if (chunk->capacity > pool_->max_chunk_size()) {
+        delete chunk;  // 超出最大规格的合并块不来自内存池（见linearize）
+        return;
     }
+    pool_->retrieve(chunk);
 }
 
+// 释放一段经next串联的内存块链表
+void BufferBase::release_chain(Chunk* head) {
+    while (head != nullptr) {
+        Chunk* next = head->next;
+        release_chunk(head);
+        head = next;
+    }
+}
 
 BufferBase::~BufferBase() {
     try {
@@ -36,387 +59,534 @@ BufferBase::~BufferBase() {
 }
 
 int BufferBase::length() const {
-    return data_buf != nullptr ? static_cast<int>(data_buf->length) : 0;
+    return static_cast<int>(total_len);
 }
 
 void BufferBase::pop(int len) {
-    if (data_buf == nullptr) {
+    if (head_buf == nullptr) {
         PR_WARN("Attempt to pop from nullptr buffer");
         return;
     }
-    
+
     if (len <= 0) {
         PR_WARN("Invalid pop length: %d", len);
         return;
     }
-    
-    if (static_cast<size_t>(len) > data_buf->length) {
-        PR_ERROR("Pop length %d exceeds buffer length %zu", 
-                len, data_buf->length);
+
+    if (static_cast<size_t>(len) > total_len) {
+        PR_ERROR("Pop length %d exceeds buffer length %zu",
+                len, total_len);
         throw std::runtime_error("Pop length exceeds buffer length");
     }
-    
-    try {
-        data_buf->pop(static_cast<size_t>(len));
-        
-        if (data_buf->length == 0) {
-            MemoryPool::get_instance().retrieve(data_buf);
-            data_buf = nullptr;
-            PR_DEBUG("Buffer emptied and returned to pool");
+
+    // 从链头依次消费，消费完的块立即归还内存池
+    size_t remaining = static_cast<size_t>(len);
+    while (remaining > 0) {
+        Chunk* chunk = head_buf;
+        size_t n = std::min(remaining, chunk->length);
+        chunk->pop(n);
+        total_len -= n;
+        remaining -= n;
+
+        if (chunk->length == 0) {
+            head_buf = chunk->next;
+            release_chunk(chunk);
         }
-    } catch (const std::exception& e) {
-        PR_ERROR("Failed to pop buffer: %s", e.what());
-        throw;
+    }
+
+    if (head_buf == nullptr) {
+        tail_buf = nullptr;
+        PR_DEBUG("Buffer emptied and returned to pool");
     }
 }
 
 void BufferBase::clear() {
-    if (data_buf != nullptr) {
+    Chunk* head = head_buf;
+    head_buf = nullptr;
+    tail_buf = nullptr;
+    total_len = 0;
+    if (head != nullptr) {
         try {
-            MemoryPool::get_instance().retrieve(data_buf);
-            data_buf = nullptr;
+            release_chain(head);
             PR_DEBUG("Buffer cleared and returned to pool");
         } catch (const std::exception& e) {
             PR_ERROR("Failed to clear buffer: %s", e.what());
-            // 尝试继续执行，避免内存泄漏
-            data_buf = nullptr;
         }
     }
 }
 
-// InputBuffer 实现
-bool InputBuffer::ensure_space_available(int additional_size) {
-    // 参数验证
-    if (additional_size <= 0) {
-        PR_ERROR("ensure_space_available: invalid size %d", additional_size);
-        return false;
-    }
-    
-    // 大小限制
-    static constexpr int MAX_ALLOWED_SIZE = 1024 * 1024;  // 1MB
-    if (additional_size > MAX_ALLOWED_SIZE) {
-        PR_ERROR("ensure_space_available: size %d > max %d",
-                additional_size, MAX_ALLOWED_SIZE);
-        return false;
-    }
-    
-    // 安全转换
-    size_t additional;
-    if (!safe_int_to_size(additional_size, additional)) {
-        PR_ERROR("ensure_space_available: negative size %d", additional_size);
-        return false;
-    }
-    
-    if (data_buf == nullptr) {
-        // 初始分配
-        int alloc_size = std::max(additional_size, DEFAULT_BUFFER_SIZE);
-        size_t safe_size;
-        if (!safe_int_to_size(alloc_size, safe_size)) {
-            PR_ERROR("ensure_space_available: alloc_size invalid %d", alloc_size);
-            return false;
-        }
-        
-        try {
-            data_buf = MemoryPool::get_instance().alloc_chunk(safe_size);
-        } catch (...) {
-            PR_ERROR("Failed to allocate buffer");
-            return false;
-        }
-        
-        if (!data_buf) {
-            PR_ERROR("Allocation returned nullptr");
-            return false;
-        }
-        return true;
-    }
-    
-    // 确保数据已调整
-    if (data_buf->head != 0) {
-        adjust();
-    }
-    
-    // 检查是否需要扩容
-    size_t available = data_buf->capacity - data_buf->length;
-    if (available >= additional) {
-        return true;
-    }
-    
-    // 安全计算需要的大小
-    size_t needed = additional - available;
-    int needed_int;
-    if (needed > static_cast<size_t>(std::numeric_limits<int>::max())) {
-        PR_ERROR("needed size too large: %zu", needed);
-        return false;
-    }
-    needed_int = static_cast<int>(needed);
-    
-    return expand_buffer(needed_int);
+size_t BufferBase::tail_space() const {
+    if (tail_buf == nullptr) return 0;
+    return tail_buf->capacity - tail_buf->head - tail_buf->length;
 }
 
-bool InputBuffer::expand_buffer(int needed_size) {
-    assert(data_buf != nullptr);
-    
-    size_t new_size = data_buf->length + static_cast<size_t>(needed_size);
-    Chunk* new_buf = nullptr;
-    
+// 每次搬移量不超过此前从该块pop掉的字节数，所以搬移总量摊还到每字节O(1)
+void BufferBase::compact_tail(size_t want) {
+    Chunk* c = tail_buf;
+    if (c == nullptr || c->head == 0 || c->block != nullptr || c->file_fd >= 0) return;
+    if (tail_space() >= want || c->length > c->head) return;
+    c->adjust();
+    PR_DEBUG("Buffer tail compacted, %zu bytes moved", c->length);
+}
+
+Chunk* BufferBase::alloc_chain_chunk(size_t size) {
+    // 规格表的最大规格可能小于MAX_CHAIN_CHUNK_SIZE，上限取两者较小值
+    size = std::min({std::max(size, MIN_CHAIN_CHUNK_SIZE), MAX_CHAIN_CHUNK_SIZE, pool_->max_chunk_size()});
+    Chunk* chunk = nullptr;
     try {
-        new_buf = MemoryPool::get_instance().alloc_chunk(new_size);
+        chunk = pool_->alloc_chunk(size);
     } catch (const MemoryPoolExhaustedError& e) {
-        PR_ERROR("Memory pool exhausted while expanding: %s", e.what());
-        return false;
+        PR_ERROR("Memory pool exhausted: %s", e.what());
+        return nullptr;
     } catch (const MemoryAllocationError& e) {
         PR_ERROR("Memory allocation failed: %s", e.what());
-        return false;
+        return nullptr;
     }
-    
-    if (new_buf == nullptr) {
-        PR_ERROR("Failed to expand buffer to size %zu", new_size);
-        return false;
+    if (chunk == nullptr) {
+        PR_ERROR("Allocation returned nullptr");
+    } else if (account_ != nullptr) {
+        account_->charge(chunk->capacity);
     }
-    
-    // 复制数据
-    try {
-        new_buf->copy(data_buf);
-    } catch (const std::exception& e) {
-        PR_ERROR("Failed to copy buffer data: %s", e.what());
-        MemoryPool::get_instance().retrieve(new_buf);
-        return false;
+    return chunk;
+}
+
+void BufferBase::append_chunk(Chunk* chunk) {
+    assert(chunk != nullptr && chunk->next == nullptr);
+    if (tail_buf == nullptr) {
+        head_buf = chunk;
+    } else {
+        tail_buf->next = chunk;
+    }
+    tail_buf = chunk;
+    total_len += chunk->length;
+}
+
+// 先填满链尾剩余空间，放不下的部分写入新挂接的块；新块全部申请成功后才写入，失败时缓冲区保持不变
+bool BufferBase::append(const char* data, size_t len) {
+    compact_tail(len);
+    size_t remaining = len;
+    size_t in_tail = std::min(remaining, tail_space());
+
+    // 为放不下的部分申请新块
+    Chunk* new_head = nullptr;
+    Chunk* new_tail = nullptr;
+    for (size_t need = remaining - in_tail; need > 0;) {
+        Chunk* c = alloc_chain_chunk(need);
+        if (c == nullptr) {
+            release_chain(new_head);
+            return false;
+        }
+        if (new_tail == nullptr) {
+            new_head = c;
+        } else {
+            new_tail->next = c;
+        }
+        new_tail = c;
+        need -= std::min(need, c->capacity);
+    }
+
+    // 写入数据
+    if (in_tail > 0) {
+        std::memcpy(tail_buf->data + tail_buf->head + tail_buf->length, data, in_tail);
+        tail_buf->length += in_tail;
+        total_len += in_tail;
+        data += in_tail;
+        remaining -= in_tail;
+    }
+    while (new_head != nullptr) {
+        Chunk* c = new_head;
+        new_head = c->next;
+        c->next = nullptr;
+        size_t n = std::min(remaining, c->capacity);
+        std::memcpy(c->data, data, n);
+        c->length = n;
+        data += n;
+        remaining -= n;
+        append_chunk(c);
     }
-    
-    // 交换缓冲区
-    MemoryPool::get_instance().retrieve(data_buf);
-    data_buf = new_buf;
-    
-    PR_DEBUG("Buffer expanded from %zu to %zu bytes", 
-            data_buf->capacity, new_buf->capacity);
-    
     return true;
 }
 
+// InputBuffer 实现
+// 一次readv同时填充链尾剩余空间和一段额外空间：
+// kExtraBuf模式下额外空间是线程局部临时缓冲区，读入其中的数据再追加到链上（空闲连接不占用内存块）
+// kSpareChunk模式下额外空间是预先申请的新块，只有在实际读到数据时才挂接，否则立即归还
 int InputBuffer::read_from_fd(int fd) {
     if (fd < 0) {
         PR_ERROR("Invalid fd: %d", fd);
+        errno = EBADF;
         return -1;
     }
-    
-    // 确保有默认空间
-    if (!ensure_space_available(DEFAULT_BUFFER_SIZE)) {
-        PR_ERROR("Failed to ensure space");
-        return -1;
+
+    thread_local char extrabuf[EXTRA_BUF_SIZE];
+
+    struct iovec iov[2];
+    int iovcnt = 0;
+    compact_tail(MIN_CHAIN_CHUNK_SIZE);
+    size_t space = tail_space();
+    if (space > 0) {
+        iov[iovcnt].iov_base = tail_buf->data + tail_buf->head + tail_buf->length;
+        iov[iovcnt].iov_len = space;
+        ++iovcnt;
     }
-    
-    if (!data_buf) {
-        PR_ERROR("Buffer not allocated");
-        return -1;
+
+    Chunk* extra = nullptr;
+    if (read_mode_ == ReadMode::kExtraBuf) {
+        iov[iovcnt].iov_base = extrabuf;
+        iov[iovcnt].iov_len = sizeof(extrabuf);
+        ++iovcnt;
+    } else if (space < std::min(MAX_CHAIN_CHUNK_SIZE, pool_->max_chunk_size())) {
+        // 链尾空间不足一个最大块时，额外准备一个新块（大小随已缓存数据量增长）
+        extra = alloc_chain_chunk(total_len);
+        if (extra != nullptr) {
+            iov[iovcnt].iov_base = extra->data;
+            iov[iovcnt].iov_len = extra->capacity;
+            ++iovcnt;
+        }
     }
-    
-    // 读取数据
-    size_t available = data_buf->capacity - data_buf->length;
-    if (available == 0) {
-        PR_ERROR("No space in buffer");
+
+    if (iovcnt == 0) {
+        PR_ERROR("Failed to ensure space");
+        errno = ENOMEM;  // 内部分配失败也要给出errno，否则调用方可能沿用上一次的EAGAIN而把错误当作“暂无数据”
         return -1;
     }
-    
-    // 限制读取大小，防止一次读取过多
-    size_t to_read = std::min(available, static_cast<size_t>(65536));  // 64KB max
-    
+
     ssize_t bytes_read;
     do {
-        bytes_read = read(fd, data_buf->data + data_buf->length, to_read);
+        bytes_read = ::readv(fd, iov, iovcnt);
     } while (bytes_read == -1 && errno == EINTR);
-    
+
     if (bytes_read > 0) {
-        data_buf->length += static_cast<size_t>(bytes_read);
+        size_t n = static_cast<size_t>(bytes_read);
+        size_t in_tail = std::min(n, space);
+        if (in_tail > 0) {
+            tail_buf->length += in_tail;
+            total_len += in_tail;
+        }
+        if (extra != nullptr) {
+            if (n > in_tail) {
+                extra->length = n - in_tail;
+                append_chunk(extra);
+            } else {
+                release_chunk(extra);
+            }
+        } else if (n > in_tail && !append(extrabuf, n - in_tail)) {
+            // 临时缓冲区中的数据无法转存，已从socket读出，只能按错误处理
+            PR_ERROR("Failed to buffer %zu bytes read from fd %d", n - in_tail, fd);
+            errno = ENOMEM;
+            return -1;
+        }
         PR_DEBUG("Read %zd bytes", bytes_read);
         return static_cast<int>(bytes_read);
-    } else if (bytes_read == 0) {
+    }
+
+    int err = errno;
+    if (extra != nullptr) {
+        release_chunk(extra);
+    }
+    if (bytes_read == 0) {
         PR_DEBUG("EOF on fd %d", fd);
         return 0;
-    } else {
-        int err = errno;
-        if (err == EAGAIN || err == EWOULDBLOCK) {
-            return 0;
-        }
+    }
+    if (err != EAGAIN && err != EWOULDBLOCK) {
         PR_ERROR("Read failed on fd %d: %s", fd, strerror(err));
-        return -1;
     }
+    errno = err;  // 调用方据此区分“暂无数据”与真正的错误
+    return -1;
 }
 
-// 读取缓冲区数据
-const char* InputBuffer::get_from_buf() const {
-    if (data_buf == nullptr) {
+// 读取缓冲区数据：数据分布在多个块时先合并，保证返回的指针后有length()字节连续数据
+const char* InputBuffer::get_from_buf() {
+    if (head_buf == nullptr) {
         return nullptr;
     }
-    return data_buf->data + data_buf->head;
-}
-
-void InputBuffer::adjust() {
-    if (data_buf != nullptr && data_buf->head > 0) {
-        size_t old_head = data_buf->head;
-        data_buf->adjust();
-        PR_DEBUG("Buffer adjusted, head moved from %zu to 0", old_head);
+    if (head_buf->next != nullptr && !linearize()) {
+        return nullptr;
     }
+    return head_buf->data + head_buf->head;
 }
 
-// OutputBuffer 实现
-bool OutputBuffer::ensure_capacity(int additional_size) {
-    // 参数验证
-    if (additional_size <= 0) {
-        PR_ERROR("ensure_capacity: invalid size %d", additional_size);
+// 将整条链合并到一个块中（超出内存池最大规格时单独从堆上申请，不经内存池，释放时直接delete）
+bool InputBuffer::linearize() {
+    Chunk* merged = nullptr;
+    try {
+        if (total_len > pool_->max_chunk_size()) {
+            merged = new Chunk(total_len);
+        } else {
+            merged = pool_->alloc_chunk(total_len);
+        }
+    } catch (const std::exception& e) {
+        PR_ERROR("Failed to allocate buffer for linearize: %s", e.what());
         return false;
     }
-    
-    static constexpr int MAX_ALLOWED_SIZE = 1024 * 1024;  // 1MB
-    if (additional_size > MAX_ALLOWED_SIZE) {
-        PR_ERROR("ensure_capacity: size %d > max %d",
-                additional_size, MAX_ALLOWED_SIZE);
+    if (merged == nullptr) {
+        PR_ERROR("Allocation returned nullptr");
         return false;
     }
-    
-    // 安全转换
-    size_t additional;
-    if (!safe_int_to_size(additional_size, additional)) {
-        PR_ERROR("ensure_capacity: negative size %d", additional_size);
-        return false;
+
+    if (account_ != nullptr) account_->charge(merged->capacity);
+
+    for (Chunk* c = head_buf; c != nullptr; c = c->next) {
+        std::memcpy(merged->data + merged->length, c->data + c->head, c->length);
+        merged->length += c->length;
     }
-    
-    if (data_buf == nullptr) {
-        int alloc_size = std::max(additional_size, DEFAULT_BUFFER_SIZE);
-        size_t safe_size;
-        if (!safe_int_to_size(alloc_size, safe_size)) {
-            PR_ERROR("ensure_capacity: alloc_size invalid %d", alloc_size);
-            return false;
+
+    release_chain(head_buf);
+    head_buf = merged;
+    tail_buf = merged;
+    PR_DEBUG("Buffer linearized into %zu bytes", merged->capacity);
+    return true;
+}
+
+std::string_view InputBuffer::peek() {
+    const char* p = get_from_buf();
+    return p != nullptr ? std::string_view(p, total_len) : std::string_view();
+}
+
+std::string_view InputBuffer::peek(size_t len) {
+    if (len > total_len || head_buf == nullptr) {
+        return std::string_view();
+    }
+    if (head_buf->length < len && !linearize()) {
+        return std::string_view();
+    }
+    return std::string_view(head_buf->data + head_buf->head, len);
+}
+
+// 逐块查找：块内匹配直接用string_view::find；跨块匹配用上一块末尾(m-1)字节与本块开头(m-1)字节拼接后查找
+size_t InputBuffer::find(std::string_view needle, size_t from) const {
+    if (needle.empty()) {
+        return from <= total_len ? from : npos;
+    }
+    if (from >= total_len || needle.size() > total_len - from) {
+        return npos;
+    }
+
+    const size_t keep = needle.size() - 1;
+    std::string carry;      // 之前各块末尾最多keep字节
+    size_t base = 0;        // 当前块在可读数据中的起始偏移
+    for (const Chunk* c = head_buf; c != nullptr; c = c->next) {
+        std::string_view view(c->data + c->head, c->length);
+
+        if (!carry.empty()) {
+            size_t carry_base = base - carry.size();
+            std::string joined = carry;
+            joined.append(view.data(), std::min(keep, view.size()));
+            size_t start = from > carry_base ? from - carry_base : 0;
+            size_t pos = joined.find(needle.data(), start, needle.size());
+            if (pos != std::string::npos && pos < carry.size()) {
+                return carry_base + pos;
+            }
         }
-        
-        try {
-            data_buf = MemoryPool::get_instance().alloc_chunk(safe_size);
-        } catch (...) {
-            PR_ERROR("Failed to allocate buffer");
-            return false;
+
+        size_t start = from > base ? from - base : 0;
+        if (start < view.size()) {
+            size_t pos = view.find(needle, start);
+            if (pos != std::string_view::npos) {
+                return base + pos;
+            }
         }
-        
-        if (!data_buf) {
-            PR_ERROR("Allocation returned nullptr");
-            return false;
+
+        if (keep > 0) {
+            carry.append(view.data(), view.size());
+            if (carry.size() > keep) carry.erase(0, carry.size() - keep);
         }
-        return true;
-    }
-    
-    // 输出缓冲区应该总是有head为0
-    if (data_buf->head != 0) {
-        data_buf->adjust();
-    }
-    
-    // 检查空间
-    size_t available = data_buf->capacity - data_buf->length;
-    if (available >= additional) {
-        return true;
-    }
-    
-    // 需要扩容
-    size_t current_len = data_buf->length;
-    size_t new_size;
-    if (!safe_add(current_len, additional, new_size)) {
-        PR_ERROR("ensure_capacity: overflow %zu + %zu", current_len, additional);
-        return false;
+        base += view.size();
     }
-    
-    // 检查最大大小
-    static constexpr size_t MAX_BUFFER_SIZE = 1024 * 1024;  // 1MB
-    if (new_size > MAX_BUFFER_SIZE) {
-        PR_ERROR("ensure_capacity: new size %zu > max %zu", 
-                new_size, MAX_BUFFER_SIZE);
+    return npos;
+}
+
+bool InputBuffer::copy_prefix(char* dst, size_t len) const {
+    if (len > total_len) {
         return false;
     }
-    
-    Chunk* new_buf = nullptr;
-    try {
-        new_buf = MemoryPool::get_instance().alloc_chunk(new_size);
-    } catch (...) {
-        PR_ERROR("Failed to allocate expanded buffer");
-        return false;
+    for (const Chunk* c = head_buf; c != nullptr && len > 0; c = c->next) {
+        size_t n = std::min(len, c->length);
+        std::memcpy(dst, c->data + c->head, n);
+        dst += n;
+        len -= n;
     }
-    
-    if (!new_buf) {
-        PR_ERROR("Expansion allocation returned nullptr");
-        return false;
+    return true;
+}
+
+uint8_t InputBuffer::peek_uint8() const {
+    uint8_t v;
+    if (!copy_prefix(reinterpret_cast<char*>(&v), sizeof(v))) {
+        throw std::out_of_range("peek_uint8: not enough readable bytes");
     }
-    
-    // 复制数据
-    try {
-        new_buf->copy(data_buf);
-    } catch (...) {
-        MemoryPool::get_instance().retrieve(new_buf);
-        PR_ERROR("Failed to copy data");
-        return false;
+    return v;
+}
+
+uint16_t InputBuffer::peek_uint16() const {
+    uint16_t v;
+    if (!copy_prefix(reinterpret_cast<char*>(&v), sizeof(v))) {
+        throw std::out_of_range("peek_uint16: not enough readable bytes");
+    }
+    return be16toh(v);
+}
+
+uint32_t InputBuffer::peek_uint32() const {
+    uint32_t v;
+    if (!copy_prefix(reinterpret_cast<char*>(&v), sizeof(v))) {
+        throw std::out_of_range("peek_uint32: not enough readable bytes");
+    }
+    return be32toh(v);
+}
+
+uint64_t InputBuffer::peek_uint64() const {
+    uint64_t v;
+    if (!copy_prefix(reinterpret_cast<char*>(&v), sizeof(v))) {
+        throw std::out_of_range("peek_uint64: not enough readable bytes");
+    }
+    return be64toh(v);
+}
+
+void InputBuffer::adjust() {
+    if (head_buf != nullptr && head_buf->head > 0) {
+        size_t old_head = head_buf->head;
+        head_buf->adjust();
+        PR_DEBUG("Buffer adjusted, head moved from %zu to 0", old_head);
     }
-    
-    // 交换缓冲区
-    MemoryPool::get_instance().retrieve(data_buf);
-    data_buf = new_buf;
-    
-    return true;
 }
 
+// OutputBuffer 实现
 int OutputBuffer::write_to_buf(const char* data, int len) {
     if (!data) {
         PR_ERROR("Null data pointer");
         return -1;
     }
-    
+
     if (len <= 0) {
         PR_WARN("Zero or negative length: %d", len);
         return 0;
     }
-    
-    // 验证长度
-    if (len > 1024 * 1024) {  // 1MB
-        PR_ERROR("Data too large: %d bytes", len);
+
+    if (!append(data, static_cast<size_t>(len))) {
+        PR_ERROR("Failed to ensure capacity for %d bytes", len);
         return -1;
     }
-    
-    if (!ensure_capacity(len)) {
-        PR_ERROR("Failed to ensure capacity for %d bytes", len);
+    return 0;
+}
+
+// 共享块以只读视图节点挂接到链尾：视图节点容量等于数据长度，后续追加不会写入共享数据
+int OutputBuffer::write_to_buf(const SharedBuffer& buf, size_t offset) {
+    if (buf.block() == nullptr || offset >= buf.size()) {
+        return 0;
+    }
+
+    size_t len = buf.size() - offset;
+    if (len <= SHARED_COPY_THRESHOLD && len <= tail_space()) {
+        return append(buf.data() + offset, len) ? 0 : -1;
+    }
+
+    Chunk* view = nullptr;
+    try {
+        view = new Chunk(const_cast<char*>(buf.data()) + offset, len);
+    } catch (const std::bad_alloc&) {
+        PR_ERROR("Failed to allocate shared view node");
         return -1;
     }
-    
-    if (!data_buf) {
-        PR_ERROR("Buffer not allocated after ensure_capacity");
+    view->length = len;
+    view->block = buf.block();
+    view->block->retain();
+    append_chunk(view);
+    return 0;
+}
+
+// 文件区间以节点形式挂接到链尾：只复制一份fd（调用方仍负责关闭自己的fd），数据不读入用户态
+int OutputBuffer::write_file(int fd, off_t offset, size_t len) {
+    if (fd < 0 || offset < 0) {
+        PR_ERROR("Invalid file range: fd=%d offset=%lld", fd, static_cast<long long>(offset));
         return -1;
     }
-    
-    // 写入数据
-    std::memcpy(data_buf->data + data_buf->length, data, 
-               static_cast<size_t>(len));
-    data_buf->length += static_cast<size_t>(len);
-    
+    if (len == 0) {
+        return 0;
+    }
+    if (len > static_cast<size_t>(INT_MAX) - total_len) {
+        PR_ERROR("File range of %zu bytes exceeds buffer length limit", len);
+        return -1;
+    }
+
+    int dup_fd = ::fcntl(fd, F_DUPFD_CLOEXEC, 0);
+    if (dup_fd < 0) {
+        PR_ERROR("Failed to dup fd %d: %s", fd, strerror(errno));
+        return -1;
+    }
+    Chunk* range = nullptr;
+    try {
+        range = new Chunk(dup_fd, static_cast<size_t>(offset), len);
+    } catch (const std::bad_alloc&) {
+        PR_ERROR("Failed to allocate file range node");
+        ::close(dup_fd);
+        return -1;
+    }
+    append_chunk(range);
     return 0;
 }
 
+// 链头是文件区间时用sendfile发送（数据在内核中从页缓存直接送往socket）
+int OutputBuffer::write_file_to_fd(int fd) {
+    Chunk* range = head_buf;
+    off_t offset = static_cast<off_t>(range->head);
+    ssize_t bytes_written = 0;
+    do {
+        bytes_written = ::sendfile(fd, range->file_fd, &offset, range->length);
+    } while (bytes_written == -1 && errno == EINTR);
+
+    if (bytes_written > 0) {
+        pop(static_cast<int>(bytes_written));
+        return static_cast<int>(bytes_written);
+    }
+    if (bytes_written == 0) {
+        // 文件在发送期间被截断：剩余数据永远发不出去
+        PR_ERROR("File fd %d ended before %zu bytes were sent", range->file_fd, range->length);
+        return -1;
+    }
+    int err = errno;
+    if (err == EAGAIN || err == EWOULDBLOCK) {
+        PR_DEBUG("sendfile would block on fd %d", fd);
+        return 0;
+    }
+    PR_ERROR("sendfile failed on fd %d: %s", fd, strerror(err));
+    return -1;
+}
+
+// 一次writev将链上多个块写出（最多MAX_IOVECS段，遇到文件区间为止），已写出的数据从链头弹出
+// 链头是文件区间时改用sendfile；一次调用只推进其中一种，其余留给下一次可写事件
 int OutputBuffer::write_to_fd(int fd) {
     if (fd < 0) {
         PR_ERROR("Invalid file descriptor: %d", fd);
         return -1;
     }
-    
-    if (data_buf == nullptr || data_buf->length == 0) {
+
+    if (total_len == 0) {
         PR_DEBUG("No data to write to fd %d", fd);
         return 0;
     }
-    
-    assert(data_buf->head == 0 && "Output buffer should always have head at 0");
-    
+
+    if (head_buf->file_fd >= 0) {
+        return write_file_to_fd(fd);
+    }
+
+    struct iovec iov[MAX_IOVECS];
+    int iovcnt = 0;
+    for (Chunk* c = head_buf; c != nullptr && iovcnt < MAX_IOVECS; c = c->next) {
+        if (c->file_fd >= 0) break;
+        if (c->length == 0) continue;
+        iov[iovcnt].iov_base = c->data + c->head;
+        iov[iovcnt].iov_len = c->length;
+        ++iovcnt;
+    }
+
     ssize_t bytes_written = 0;
     do {
-        bytes_written = write(fd, 
-                             data_buf->data + data_buf->head,
-                             data_buf->length);
+        bytes_written = ::writev(fd, iov, iovcnt);
     } while (bytes_written == -1 && errno == EINTR);
-    
+
     if (bytes_written > 0) {
         PR_DEBUG("Wrote %zd bytes to fd %d, buffer had %zu bytes",
-                bytes_written, fd, data_buf->length);
-        
+                bytes_written, fd, total_len);
+
         try {
             pop(static_cast<int>(bytes_written));
         } catch (const std::exception& e) {
@@ -435,13 +605,13 @@ int OutputBuffer::write_to_fd(int fd) {
             return -1;
         }
     }
-    
+
     return static_cast<int>(bytes_written);
 }
 
 int OutputBuffer::available_space() const {
-    if (data_buf == nullptr) {
+    if (tail_buf == nullptr) {
         return DEFAULT_BUFFER_SIZE;
     }
-    return static_cast<int>(data_buf->capacity - data_buf->length);
+    return static_cast<int>(tail_space());
 }
@@ -1,46 +1,127 @@
 #ifndef DATA_BUF_H
 #define DATA_BUF_H
 
+#include <cstdint>
+#include <sys/types.h>
+#include <string_view>
 #include "chunk.hpp"
 #include "memory_pool.hpp"
+#include "shared_block.hpp"
+#include "memory_governor.hpp"
 #include "pr.hpp"
 
+// InputBuffer的读取方式
+enum class ReadMode {
+    kExtraBuf,    // readv读入链尾剩余空间 + 线程局部64KB临时缓冲区，仅在临时缓冲区被用到时才申请新块（默认）
+    kSpareChunk   // readv读入链尾剩余空间 + 预先申请的新块，未用到时归还
+};
+
+// 缓冲区由内存块链表组成（head_buf → ... → tail_buf，经Chunk::next串联）
+// 追加数据只在链尾写入或挂接新块，从不拷贝已有数据；消费数据从链头弹出，空块立即归还内存池
+// 内存块来自构造时指定的内存池（通常是所属EventLoop的池），缓冲区存活期间该池必须有效
 class BufferBase {
 public:
-    BufferBase() = default;
+    // pool为nullptr时使用全局单例内存池；account非空时按持有的内存块容量计费（须比缓冲区活得久）
+    explicit BufferBase(MemoryPool* pool = nullptr, MemoryAccount* account = nullptr);
     virtual ~BufferBase();
-    
+
     BufferBase(const BufferBase&) = delete;
     BufferBase& operator=(const BufferBase&) = delete;
-    
+
     int length() const;
     void pop(int len);
     void clear();
 
+    MemoryPool& memory_pool() const { return *pool_; }
+
 protected:
-    static constexpr int DEFAULT_BUFFER_SIZE = 4096;
-    Chunk* data_buf{nullptr};
+    static constexpr int DEFAULT_BUFFER_SIZE = 4096;          // 缓冲区为空时available_space()报告的可写空间
+    static constexpr size_t MIN_CHAIN_CHUNK_SIZE = 1024;      // 挂接内存块的大小下限（实际大小由内存池规格表向上取整）
+    static constexpr size_t MAX_CHAIN_CHUNK_SIZE = 64 * 1024; // 挂接内存块的大小上限
+    static constexpr int MAX_IOVECS = 64;                     // 单次readv/writev的最大分段数
+
+    // 链尾剩余可写空间
+    size_t tail_space() const;
+    // 摊还压缩：链尾块（已被部分消费的链头块）剩余空间不足want、且待搬移数据不多于已消费前缀时，
+    // 把数据移回块首以复用前缀空间；否则不动数据（稳态读写不搬移，空间不足时挂接新块）
+    void compact_tail(size_t want);
+    // 从内存池申请约size字节（限制在[MIN_CHAIN_CHUNK_SIZE, min(MAX_CHAIN_CHUNK_SIZE, 内存池最大规格)]内）的新块并计费，失败返回nullptr
+    Chunk* alloc_chain_chunk(size_t size);
+    // 释放单个节点/整条链（撤销计费并归还内存池，超出最大规格的合并块直接delete，共享块视图只释放引用）
+    void release_chunk(Chunk* chunk);
+    void release_chain(Chunk* head);
+    // 将新块挂接到链尾
+    void append_chunk(Chunk* chunk);
+    // 追加len字节数据：先填满链尾剩余空间，再挂接新块；新块申请失败时缓冲区保持不变
+    bool append(const char* data, size_t len);
+
+    MemoryPool* pool_;
+    MemoryAccount* account_;
+    Chunk* head_buf{nullptr};
+    Chunk* tail_buf{nullptr};
+    size_t total_len{0};     // 链上全部有效数据的字节数
 };
 
 class InputBuffer : public BufferBase {
 public:
+    static constexpr size_t EXTRA_BUF_SIZE = 64 * 1024;  // kExtraBuf模式下线程局部临时缓冲区的大小
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+    explicit InputBuffer(MemoryPool* pool = nullptr, MemoryAccount* account = nullptr) : BufferBase(pool, account) {}
+
+    // 读取一次：返回读入的字节数；对端关闭（EOF）返回0；
+    // 出错返回-1并保留errno，非阻塞fd暂无数据时errno为EAGAIN/EWOULDBLOCK；
+    // 缓冲区内存申请失败时errno为ENOMEM（此时可能已从fd读出数据，调用方应关闭连接）
     int read_from_fd(int fd);
-    const char* get_from_buf() const;
+    // 返回全部可读数据的连续视图（数据跨多个块时先合并为一个块）
+    const char* get_from_buf();
+    // 强制把链头块的数据移回块首（读写路径已按摊还策略自动压缩，一般无需调用）
     void adjust();
-    
+
+    // 零拷贝读取接口：返回的视图指向缓冲区内部，在下一次read_from_fd/pop/clear之前有效
+    // 可读数据的连续视图（跨块时先合并）
+    std::string_view peek();
+    // 前len字节的连续视图（首块足够时不合并），可读数据不足len时返回空视图
+    std::string_view peek(size_t len);
+
+    // 从偏移from开始查找needle（支持跨块匹配，不合并不拷贝），返回相对可读数据起点的偏移，未找到返回npos
+    size_t find(std::string_view needle, size_t from = 0) const;
+    size_t find_crlf(size_t from = 0) const { return find("\r\n", from); }
+
+    // 按网络字节序（大端）读取开头的整数，不消费数据；可读数据不足时抛出std::out_of_range
+    uint8_t peek_uint8() const;
+    uint16_t peek_uint16() const;
+    uint32_t peek_uint32() const;
+    uint64_t peek_uint64() const;
+
+    void set_read_mode(ReadMode mode) { read_mode_ = mode; }
+    ReadMode read_mode() const { return read_mode_; }
+
 private:
-    bool expand_buffer(int needed_size);
-    bool ensure_space_available(int additional_size);
+    bool linearize();
+    // 从可读数据开头拷贝len字节到dst（可跨块），数据不足返回false
+    bool copy_prefix(char* dst, size_t len) const;
+
+    ReadMode read_mode_{ReadMode::kExtraBuf};
 };
 
 class OutputBuffer : public BufferBase {
 public:
+    static constexpr size_t SHARED_COPY_THRESHOLD = 256;  // 不超过该大小且链尾放得下的共享数据直接拷贝
+
+    explicit OutputBuffer(MemoryPool* pool = nullptr, MemoryAccount* account = nullptr) : BufferBase(pool, account) {}
+
     int write_to_buf(const char* data, int len);
+    // 按引用追加共享块中从offset开始的数据（不拷贝数据，只挂接一个只读视图节点）
+    int write_to_buf(const SharedBuffer& buf, size_t offset = 0);
+    // 追加文件区间[offset, offset+len)：发送时由sendfile直接从文件送出，不经过用户态
+    // 缓冲区持有fd的副本（调用方可随即关闭fd），文件内容在发出前不应被截断
+    int write_file(int fd, off_t offset, size_t len);
     int write_to_fd(int fd);
     int available_space() const;
-    
+
 private:
-    bool ensure_capacity(int additional_size);
+    int write_file_to_fd(int fd);
 };
 
-#endif // DATA_BUF_H
\ No newline at end of file
+#endif // DATA_BUF_H
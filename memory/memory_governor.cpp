@@ -0,0 +1,105 @@
+#include "memory_governor.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include "pr.hpp"
+
+MemoryAccount::~MemoryAccount() {
+    // 账户销毁时仍有余额（持有者未归还全部内存块）：从上级撤销，避免全局占用虚高
+    size_t left = bytes();
+    if (left > 0) uncharge(left);
+}
+
+void MemoryAccount::charge(size_t bytes) {
+    bytes_.fetch_add(bytes, std::memory_order_relaxed);
+    if (parent_ != nullptr) {
+        parent_->charge(bytes);
+    } else {
+        MemoryGovernor::instance().charge(bytes);
+    }
+}
+
+void MemoryAccount::uncharge(size_t bytes) {
+    bytes_.fetch_sub(bytes, std::memory_order_relaxed);
+    if (parent_ != nullptr) {
+        parent_->uncharge(bytes);
+    } else {
+        MemoryGovernor::instance().uncharge(bytes);
+    }
+}
+
+MemoryGovernor& MemoryGovernor::instance() {
+    static MemoryGovernor governor;
+    return governor;
+}
+
+void MemoryGovernor::set_budget(size_t budget_bytes, double pause_reads_ratio,
+                                double stop_accept_ratio, double shed_ratio) {
+    if (!(pause_reads_ratio > 0 && pause_reads_ratio <= stop_accept_ratio &&
+          stop_accept_ratio <= shed_ratio && shed_ratio <= 1.0)) {
+        throw std::invalid_argument("MemoryGovernor: thresholds must satisfy 0 < pause <= stop <= shed <= 1");
+    }
+    const size_t none = static_cast<size_t>(-1);
+    auto at = [budget_bytes, none](double ratio) {
+        return budget_bytes == 0 ? none : static_cast<size_t>(static_cast<double>(budget_bytes) * ratio);
+    };
+    pause_at_.store(at(pause_reads_ratio), std::memory_order_relaxed);
+    stop_at_.store(at(stop_accept_ratio), std::memory_order_relaxed);
+    shed_at_.store(at(shed_ratio), std::memory_order_relaxed);
+    budget_.store(budget_bytes, std::memory_order_relaxed);
+    PR_INFO("MemoryGovernor budget set to %zu bytes", budget_bytes);
+    update_level(used());
+}
+
+size_t MemoryGovernor::threshold(MemoryPressure level) const {
+    switch (level) {
+        case MemoryPressure::kNormal:     return 0;
+        case MemoryPressure::kPauseReads: return pause_at_.load(std::memory_order_relaxed);
+        case MemoryPressure::kStopAccept: return stop_at_.load(std::memory_order_relaxed);
+        case MemoryPressure::kShed:       return shed_at_.load(std::memory_order_relaxed);
+    }
+    return static_cast<size_t>(-1);
+}
+
+MemoryPressure MemoryGovernor::level_for(size_t used) const {
+    if (used >= shed_at_.load(std::memory_order_relaxed)) return MemoryPressure::kShed;
+    if (used >= stop_at_.load(std::memory_order_relaxed)) return MemoryPressure::kStopAccept;
+    if (used >= pause_at_.load(std::memory_order_relaxed)) return MemoryPressure::kPauseReads;
+    return MemoryPressure::kNormal;
+}
+
+// 计费路径只做一次原子加与几次比较；等级变化时才加锁通知
+void MemoryGovernor::charge(size_t bytes) {
+    size_t now = used_.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    update_level(now);
+}
+
+void MemoryGovernor::uncharge(size_t bytes) {
+    size_t now = used_.fetch_sub(bytes, std::memory_order_relaxed) - bytes;
+    update_level(now);
+}
+
+// 并发计费可能让通知乱序，监听者应以pressure()的当前值为准
+void MemoryGovernor::update_level(size_t used) {
+    int next = static_cast<int>(level_for(used));
+    if (level_.load(std::memory_order_relaxed) == next) return;
+    if (level_.exchange(next, std::memory_order_relaxed) == next) return;
+
+    std::lock_guard<std::mutex> lock(listeners_mutex_);
+    for (auto& listener : listeners_) {
+        listener.second(static_cast<MemoryPressure>(next));
+    }
+}
+
+int MemoryGovernor::add_listener(PressureCallback cb) {
+    std::lock_guard<std::mutex> lock(listeners_mutex_);
+    int id = next_listener_id_++;
+    listeners_.emplace_back(id, std::move(cb));
+    return id;
+}
+
+void MemoryGovernor::remove_listener(int id) {
+    std::lock_guard<std::mutex> lock(listeners_mutex_);
+    listeners_.erase(std::remove_if(listeners_.begin(), listeners_.end(),
+                                    [id](const auto& l) { return l.first == id; }),
+                     listeners_.end());
+}
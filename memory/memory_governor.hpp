@@ -0,0 +1,91 @@
+#ifndef MEMORY_GOVERNOR_HPP
+#define MEMORY_GOVERNOR_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+// 内存压力等级（按预算占用比例逐级升高，每一级包含前一级的措施）
+enum class MemoryPressure {
+    kNormal,      // 正常
+    kPauseReads,  // 暂停读取：连接不再从socket读入新数据（输入缓冲区不再增长）
+    kStopAccept,  // 停止接受新连接
+    kShed         // 按缓冲区占用从大到小（相同时先老后新）关闭连接，直到回落到kStopAccept阈值以下
+};
+
+// MemoryAccount：缓冲区内存计费账户
+// 连接级账户挂在所属EventLoop的账户下，EventLoop账户（无父账户）再计入全局MemoryGovernor
+// 计费粒度是缓冲区持有的内存块容量（共享块视图不计费）
+class MemoryAccount {
+public:
+    explicit MemoryAccount(MemoryAccount* parent = nullptr) : parent_(parent) {}
+    ~MemoryAccount();
+
+    MemoryAccount(const MemoryAccount&) = delete;
+    MemoryAccount& operator=(const MemoryAccount&) = delete;
+
+    void charge(size_t bytes);
+    void uncharge(size_t bytes);
+    size_t bytes() const { return bytes_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<size_t> bytes_{0};
+    MemoryAccount* parent_;
+};
+
+// MemoryGovernor：进程级缓冲区内存预算
+// 占用越过各级阈值时切换压力等级并通知监听者；预算为0（默认）时只计数、不施压
+// 预算应小于内存池容量上限，使治理器先于MemoryPoolExhaustedError生效
+class MemoryGovernor {
+public:
+    using PressureCallback = std::function<void(MemoryPressure)>;
+
+    static constexpr double DEFAULT_PAUSE_READS_RATIO = 0.70;
+    static constexpr double DEFAULT_STOP_ACCEPT_RATIO = 0.85;
+    static constexpr double DEFAULT_SHED_RATIO = 0.95;
+
+    static MemoryGovernor& instance();
+
+    // 设置预算与各级阈值（占预算的比例，须满足0 < pause <= stop <= shed <= 1），参数非法时抛出std::invalid_argument
+    void set_budget(size_t budget_bytes,
+                    double pause_reads_ratio = DEFAULT_PAUSE_READS_RATIO,
+                    double stop_accept_ratio = DEFAULT_STOP_ACCEPT_RATIO,
+                    double shed_ratio = DEFAULT_SHED_RATIO);
+
+    size_t budget() const { return budget_.load(std::memory_order_relaxed); }
+    size_t used() const { return used_.load(std::memory_order_relaxed); }
+    MemoryPressure pressure() const { return static_cast<MemoryPressure>(level_.load(std::memory_order_relaxed)); }
+    // 进入指定压力等级的占用阈值（字节），预算为0时返回SIZE_MAX
+    size_t threshold(MemoryPressure level) const;
+
+    // 注册压力等级变化监听者，返回用于注销的id
+    // 回调在触发计费的线程中、持有监听者锁时调用：只应投递任务（如queueInLoop），不可阻塞或再调用本类的注册接口
+    int add_listener(PressureCallback cb);
+    // 注销监听者：返回后该回调不会再被调用
+    void remove_listener(int id);
+
+    void charge(size_t bytes);
+    void uncharge(size_t bytes);
+
+private:
+    MemoryGovernor() = default;
+
+    void update_level(size_t used);
+    MemoryPressure level_for(size_t used) const;
+
+    std::atomic<size_t> used_{0};
+    std::atomic<size_t> budget_{0};
+    std::atomic<size_t> pause_at_{static_cast<size_t>(-1)};
+    std::atomic<size_t> stop_at_{static_cast<size_t>(-1)};
+    std::atomic<size_t> shed_at_{static_cast<size_t>(-1)};
+    std::atomic<int> level_{static_cast<int>(MemoryPressure::kNormal)};
+
+    std::mutex listeners_mutex_;
+    std::vector<std::pair<int, PressureCallback>> listeners_;
+    int next_listener_id_{0};
+};
+
+#endif // MEMORY_GOVERNOR_HPP
@@ -1,64 +1,261 @@
 #include "memory_pool.hpp"
+#include "poison.hpp"
+#include "pool_allocator.hpp"
 #include <iostream>
 #include <algorithm>
 #include <cassert>
+#include <chrono>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+namespace {
+    // 计算指定大小规格的线程缓存上限（块数），大规格为0表示不做线程缓存
+    constexpr size_t cache_limit_for(size_t chunk_size) {
+        return std::min(THREAD_CACHE_MAX_CHUNKS, THREAD_CACHE_BYTES_PER_CLASS / chunk_size);
+    }
+
+    // 单次与全局链表交换的批量大小（缓存上限的一半，保证交换后缓存仍有余量）
+    constexpr size_t cache_batch_for(size_t chunk_size) {
+        return std::max<size_t>(1, cache_limit_for(chunk_size) / 2);
+    }
+
+    // 单例的构造参数：configure()写入，首次get_instance()时取出
+    struct InstanceConfig {
+        std::mutex mutex;
+        PoolConfig config;
+        bool created = false;
+    };
+
+    InstanceConfig& instance_config_holder() {
+        static InstanceConfig holder;
+        return holder;
+    }
 
-// 内存池构造函数（私有，单例模式）
-MemoryPool::MemoryPool()
-    : max_capacity_bytes_(128 * 1024 * 1024)  // 默认最大容量128MB
+    // 线程缓存注册锁：保护线程缓存与内存池之间的绑定关系
+    // 线程退出（缓存析构）与内存池析构可能并发，二者均在此锁下进行
+    std::mutex& cache_registry_mutex() {
+        static std::mutex m;
+        return m;
+    }
+
+    int64_t steady_now_ns() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+}
+
+// 线程本地缓存：每种规格一个magazine（以Chunk::next串成的单链表）
+// 仅由所属线程访问；owner在绑定/解绑时于注册锁下修改
+struct MemoryPool::ThreadCache {
+    struct Magazine {
+        Chunk* head = nullptr;
+        size_t count = 0;
+    };
+
+    std::atomic<MemoryPool*> owner{nullptr};
+    std::array<Magazine, MAX_SIZE_CLASSES> mags{};
+
+    ~ThreadCache() {
+        std::lock_guard<std::mutex> lock(cache_registry_mutex());
+        MemoryPool* pool = owner.load(std::memory_order_relaxed);
+        if (!pool) return;
+        // 线程退出：缓存中的块全部归还给所属内存池，并解除注册
+        pool->flush_cache(*this);
+        auto& caches = pool->thread_caches_;
+        caches.erase(std::remove(caches.begin(), caches.end(), this), caches.end());
+        owner.store(nullptr, std::memory_order_relaxed);
+    }
+};
+
+// 内存池构造函数
+MemoryPool::MemoryPool(const PoolConfig& config)
+    : config_(config)
+    , max_capacity_bytes_(128 * 1024 * 1024)  // 默认最大容量128MB
     , current_usage_bytes_(0)                 // 初始使用量为0
     , preallocated_bytes_(0)                  // 初始预分配字节数为0
-    , stats_()                                // 初始化统计信息（默认值）
 {
-    // 预置所有规格的键，值为 nullptr（便于后续逻辑统一处理，避免key不存在）
-    for (size_t s : MEM_SIZES) pool_[s] = nullptr;
+    validate(config_);
+    build_class_table();
+    if (config_.slab_bytes == 0) config_.slab_bytes = class_sizes_[0];
+    for (size_t cls = 0; cls < class_count_; ++cls) {
+        auto& spec = config_.classes[cls];
+        spec.high_watermark = std::max(spec.high_watermark, spec.low_watermark);
+        if (slab_backed_[cls]) {
+            // slab一次补充整个slab的块：高水位至少能容纳低水位 + 一个slab，否则新slab刚入链就被裁掉一半，
+            // 反复commit/decommit（细粒度小规格一个2MB slab有上千个块，远超其默认高水位）
+            size_t per_slab = std::max<size_t>(1, config_.slab_bytes / class_sizes_[cls]);
+            spec.high_watermark = std::max(spec.high_watermark, spec.low_watermark + per_slab);
+        }
+    }
+    trim_epoch_ns_.store(steady_now_ns(), std::memory_order_relaxed);
     initialize_pool();
+    for (auto& counter : free_counts_) {
+        counter.min_free.store(counter.free.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+    small_objects_ = std::make_unique<SmallObjectHeap>(*this);
+}
+
+// 设置单例的构造参数（单例创建后不可再修改）
+void MemoryPool::configure(const PoolConfig& config) {
+    validate(config);
+    InstanceConfig& holder = instance_config_holder();
+    std::lock_guard<std::mutex> lock(holder.mutex);
+    if (holder.created) {
+        throw std::logic_error("MemoryPool::configure must be called before first get_instance()");
+    }
+    holder.config = config;
+}
+
+// 取出单例的构造参数（仅在单例构造时调用一次）
+PoolConfig MemoryPool::instance_config() {
+    InstanceConfig& holder = instance_config_holder();
+    std::lock_guard<std::mutex> lock(holder.mutex);
+    holder.created = true;
+    return holder.config;
+}
+
+// 校验规格表
+void MemoryPool::validate(const PoolConfig& config) {
+    const auto& classes = config.classes;
+    if (classes.empty() || classes.size() > MAX_SIZE_CLASSES) {
+        throw std::invalid_argument("PoolConfig: size class count must be in [1, " +
+                                    std::to_string(MAX_SIZE_CLASSES) + "]");
+    }
+    for (size_t i = 0; i < classes.size(); ++i) {
+        size_t size = classes[i].size;
+        if (size < MIN_CLASS_SIZE || (size & (size - 1)) != 0) {
+            throw std::invalid_argument("PoolConfig: size class " + std::to_string(size) +
+                                        " is not a power of two >= " + std::to_string(MIN_CLASS_SIZE));
+        }
+        if (i > 0 && size <= classes[i - 1].size) {
+            throw std::invalid_argument("PoolConfig: size classes must be strictly increasing");
+        }
+    }
+}
+
+// 构建规格表：规格均为2的幂，因此“第一个不小于n的规格”只取决于ceil_log2(n)，可预先打表
+void MemoryPool::build_class_table() {
+    class_count_ = config_.classes.size();
+    for (size_t cls = 0; cls < class_count_; ++cls) {
+        class_sizes_[cls] = config_.classes[cls].size;
+        cache_limits_[cls] = cache_limit_for(class_sizes_[cls]);
+        cache_batches_[cls] = cache_batch_for(class_sizes_[cls]);
+        bool huge = config_.huge_pages != HugePageMode::kNone && class_sizes_[cls] >= config_.huge_page_min_size;
+        class_huge_[cls] = huge ? config_.huge_pages : HugePageMode::kNone;
+        slab_backed_[cls] = huge || config_.backing == ChunkBacking::kSlab;
+        uses_slabs_ = uses_slabs_ || slab_backed_[cls];
+    }
+    size_t cls = 0;
+    for (size_t k = 0; k < log2_class_.size(); ++k) {
+        while (cls < class_count_ && class_sizes_[cls] < (k < 64 ? (size_t{1} << k) : SIZE_MAX)) ++cls;
+        log2_class_[k] = static_cast<uint8_t>(cls);
+    }
 }
 
 // 内存池析构函数
 MemoryPool::~MemoryPool() {
-    clear();
+    {
+        // 仍存活线程的缓存：其中的块收回全局链表并解除绑定，避免线程退出时访问已析构的内存池
+        std::lock_guard<std::mutex> lock(cache_registry_mutex());
+        for (ThreadCache* cache : thread_caches_) {
+            flush_cache(*cache);
+            cache->owner.store(nullptr, std::memory_order_relaxed);
+        }
+        thread_caches_.clear();
+    }
+    // 注意：析构时不能再访问线程缓存（主线程的thread_local可能已先于单例析构）
+    release_free_lists();
+
+    // 内存池已无并发访问者，此时才真正释放所有头部
+    for (Chunk* c : spare_headers_) delete c;
+    spare_headers_.clear();
+
+    // 仍有块在使用中的slab不能解除映射，放弃其所有权（与堆模式下未归还的块一致，视为泄漏）
+    for (auto& slabs : slabs_) {
+        for (auto& slab : slabs) {
+            if (slab->is_mapped()) slab.release();
+        }
+    }
 }
 
 // 清空内存池所有资源
 void MemoryPool::clear() {
-    std::lock_guard<std::mutex> lock(mutex_);
+    // 当前线程的缓存先归还到全局链表，随后统一释放
+    ThreadCache* cache = local_cache();
+    if (cache) flush_cache(*cache);
+    release_free_lists();
+}
 
-    // 遍历所有规格的内存块链表，逐个释放
-    for (auto& pair : pool_) {
-        Chunk* current = pair.second;
-        while (current != nullptr) {
-            Chunk* next = current->next;  // 先保存下一个节点，避免释放后指针失效
-            delete current;               // 释放当前内存块
-            current = next;
-        }
-        pair.second = nullptr;  // 清空链表头指针
+// 释放全局链表中的所有内存块并重置状态
+void MemoryPool::release_free_lists() {
+    for (size_t cls = 0; cls < class_count_; ++cls) {
+        // 整体摘下该规格的空闲链表
+        Chunk* list = free_lists_[cls].pop_all();
+        size_t n = 0;
+        for (Chunk* c = list; c != nullptr; c = c->next) ++n;
+        note_pop(cls, n);
+        release_chunks(cls, list);
     }
 
     // 重置所有状态
-    pool_.clear();                  // 清空内存池映射表
-    current_usage_bytes_ = 0;       // 重置当前使用量
-    preallocated_bytes_ = 0;        // 重置预分配字节数
-    stats_ = PoolStats();           // 重置统计信息
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        preallocated_bytes_ = 0;    // 重置预分配字节数
+    }
+    current_usage_bytes_.store(0, std::memory_order_relaxed);  // 重置当前使用量
+    peak_usage_bytes_.store(0, std::memory_order_relaxed);     // 重置统计信息
+    for (auto& shard : stat_shards_) {
+        shard.allocations.store(0, std::memory_order_relaxed);
+        shard.deallocations.store(0, std::memory_order_relaxed);
+        shard.failures.store(0, std::memory_order_relaxed);
+        for (auto& c : shard.hits) c.store(0, std::memory_order_relaxed);
+        for (auto& c : shard.misses) c.store(0, std::memory_order_relaxed);
+        for (auto& c : shard.request_count) c.store(0, std::memory_order_relaxed);
+        for (auto& c : shard.request_bytes) c.store(0, std::memory_order_relaxed);
+    }
 }
 
 // 初始化内存池
 void MemoryPool::initialize_pool() {
-    preallocate_chunks(MEM_SIZES[0], 200);  
-    preallocate_chunks(MEM_SIZES[1], 50);  
-    preallocate_chunks(MEM_SIZES[2], 20); 
-    preallocate_chunks(MEM_SIZES[3], 10);   
-    preallocate_chunks(MEM_SIZES[4], 5);   
-    preallocate_chunks(MEM_SIZES[5], 2);   
+    for (const auto& spec : config_.classes) {
+        preallocate_chunks(spec.size, spec.warm_up);
+    }
 }
 
 // 预分配指定规格和数量的内存块
-// 核心优化：先在锁外分配内存块，再加锁合并到内存池，减少锁持有时间
+// 核心优化：先在锁外分配内存块，再一次CAS合并到无锁链表，减少锁持有时间
 void MemoryPool::preallocate_chunks(size_t chunk_size, size_t count) {
     if (chunk_size == 0 || count == 0) return;
 
+    size_t cls = class_index(chunk_size);
     // 计算本次预分配的总字节数
     size_t total_size = chunk_size * count;
+
+    // 加锁操作：校验并预占预分配字节数
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // 检查预分配后是否超出最大容量
+        if (preallocated_bytes_ + total_size > max_capacity_bytes_.load(std::memory_order_relaxed)) {
+            throw MemoryPoolExhaustedError("Preallocation exceeds maximum pool capacity: " + std::to_string(max_capacity_bytes_.load()));
+        }
+        preallocated_bytes_ += total_size;  // 更新预分配字节数
+    }
+
+    // slab承载：按slab整体映射，块直接进入空闲链表
+    if (slab_backed_[cls]) {
+        try {
+            Chunk* c = grow_slabs(cls, count);
+            poison_on_free(c->data, c->capacity);
+            push_global(cls, c, c, 1);
+        } catch (const std::bad_alloc&) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            preallocated_bytes_ -= total_size;
+            throw MemoryAllocationError("Failed to preallocate slab of size: " + std::to_string(chunk_size));
+        }
+        return;
+    }
+
     // 本地缓存待添加的内存块，减少锁内操作
     std::vector<Chunk*> new_nodes;
     new_nodes.reserve(count);  // 预分配vector容量，避免多次扩容
@@ -66,144 +263,459 @@ void MemoryPool::preallocate_chunks(size_t chunk_size, size_t count) {
     try {
         // 批量创建内存块（锁外操作，减少锁持有时间）
         for (size_t i = 0; i < count; ++i) {
-            new_nodes.push_back(new Chunk(chunk_size));
+            new_nodes.push_back(make_chunk(chunk_size));
         }
     } catch (const std::bad_alloc&) {
         // 分配失败时，释放已创建的内存块，避免内存泄漏
-        for (Chunk* c : new_nodes) delete c;
+        for (Chunk* c : new_nodes) park_header(c);
+        std::lock_guard<std::mutex> lock(mutex_);
+        preallocated_bytes_ -= total_size;
         throw MemoryAllocationError("Failed to preallocate chunk of size: " + std::to_string(chunk_size));
     }
 
-    // 加锁操作：将预分配的内存块加入内存池
+    // 组装本地内存块为链表，一次CAS接入对应规格的无锁链表头部
+    for (size_t i = 0; i + 1 < new_nodes.size(); ++i) {
+        new_nodes[i]->next = new_nodes[i + 1];
+    }
+    for (Chunk* c : new_nodes) poison_on_free(c->data, c->capacity);
+    push_global(cls, new_nodes.front(), new_nodes.back(), new_nodes.size());
+}
+
+// 新建指定规格的内存块
+// 堆模式：优先复用备用头部（保证头部内存在内存池存活期间稳定）
+// slab承载的规格：新建或重新映射一个slab，返回其中一个块，其余块进入空闲链表
+Chunk* MemoryPool::make_chunk(size_t chunk_size) {
+    size_t cls = class_index(chunk_size);
+    if (slab_backed_[cls]) {
+        return grow_slabs(cls, 1);
+    }
+
+    Chunk* header = nullptr;
     {
         std::lock_guard<std::mutex> lock(mutex_);
-        // 检查预分配后是否超出最大容量
-        if (preallocated_bytes_ + total_size > max_capacity_bytes_) {
-            // 超出容量，释放已创建的内存块
-            for (Chunk* c : new_nodes) delete c;
-            throw MemoryPoolExhaustedError("Preallocation exceeds maximum pool capacity: " + std::to_string(max_capacity_bytes_));
+        if (!spare_headers_.empty()) {
+            header = spare_headers_.back();
+            spare_headers_.pop_back();
         }
+    }
+    if (header == nullptr) {
+        return new Chunk(chunk_size);
+    }
 
-        // 组装本地内存块为链表（头插法准备）
-        Chunk* head = nullptr;
-        Chunk* tail = nullptr;
-        for (Chunk* c : new_nodes) {
-            c->next = nullptr;  // 清空next指针，避免野指针
-            if (!head) {        // 第一个节点
-                head = tail = c;
-            } else {            // 后续节点，尾插法组装
-                tail->next = c;
-                tail = c;
+    try {
+        *header = Chunk(chunk_size);  // 移动赋值：接管新分配的数据区
+    } catch (...) {
+        park_header(header);
+        throw;
+    }
+    return header;
+}
+
+// 释放堆块的数据区，头部放回备用列表（不delete，析构时统一释放）
+void MemoryPool::park_header(Chunk* chunk) {
+    if (chunk->owns_data) {
+        poison_on_release(chunk->data, chunk->capacity);
+        delete[] chunk->data;
+    }
+    chunk->data = nullptr;
+    chunk->owns_data = true;
+    chunk->capacity = 0;
+    chunk->clear();
+    chunk->next = nullptr;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    spare_headers_.push_back(chunk);
+}
+
+// 为指定规格补充slab，直到新增块数不少于count
+// 返回其中一个块（交给调用方），其余块串成链表压入空闲链表
+Chunk* MemoryPool::grow_slabs(size_t cls, size_t count) {
+    const size_t chunk_size = class_sizes_[cls];
+    const size_t per_slab = std::max<size_t>(1, config_.slab_bytes / chunk_size);
+
+    Chunk* result = nullptr;
+    size_t provided = 0;
+
+    // 优先复用已decommit的块（地址仍映射，首次写入时重新分配物理页）
+    Chunk* reuse_head = nullptr;
+    Chunk* reuse_tail = nullptr;
+    size_t reused = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& idle = idle_slab_chunks_[cls];
+        while (provided < count && !idle.empty()) {
+            Chunk* c = idle.back();
+            idle.pop_back();
+            find_slab(c)->recommit(c);
+            ++provided;
+            if (result == nullptr) {
+                result = c;
+                continue;
+            }
+            c->next = reuse_head;
+            if (reuse_head == nullptr) reuse_tail = c;
+            reuse_head = c;
+            ++reused;
+        }
+    }
+    if (reuse_head != nullptr) {
+        push_global(cls, reuse_head, reuse_tail, reused);
+    }
+
+    while (provided < count) {
+        Slab* slab = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            // 优先重新映射已整体归还的slab（复用其头部数组）
+            for (auto& s : slabs_[cls]) {
+                if (!s->is_mapped()) {
+                    s->remap();
+                    slab = s.get();
+                    break;
+                }
+            }
+            if (slab == nullptr) {
+                auto created = std::make_unique<Slab>(chunk_size, per_slab, config_.numa_node, class_huge_[cls]);
+                slab = created.get();
+                slab_index_[slab->header(0)] = slab;
+                slabs_[cls].push_back(std::move(created));
+            }
+        }
+
+        size_t first = 0;
+        if (result == nullptr) {
+            result = slab->header(0);
+            first = 1;
+        }
+        size_t n = slab->chunk_count();
+        if (first < n) {
+            for (size_t i = first; i + 1 < n; ++i) {
+                slab->header(i)->next = slab->header(i + 1);
             }
+            slab->header(n - 1)->next = nullptr;
+            poison_on_free(slab->header(first)->data, (n - first) * chunk_size);
+            push_global(cls, slab->header(first), slab->header(n - 1), n - first);
         }
+        provided += n;
+    }
+    return result;
+}
+
+size_t MemoryPool::get_huge_page_bytes() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t bytes = 0;
+    for (size_t cls = 0; cls < class_count_; ++cls) {
+        for (const auto& slab : slabs_[cls]) {
+            if (slab->is_mapped() && slab->is_huge()) bytes += slab->bytes();
+        }
+    }
+    return bytes;
+}
+
+// 查找头部所属的slab：头部数组按起始地址排序，upper_bound后前一个即候选（需持有mutex_）
+Slab* MemoryPool::find_slab(const Chunk* chunk) {
+    auto it = slab_index_.upper_bound(chunk);
+    if (it == slab_index_.begin()) return nullptr;
+    --it;
+    return it->second->owns(chunk) ? it->second : nullptr;
+}
+
+// 回收非标准状态的块（容量为0或被扩容过）
+// slab头部：数据区指回原槽位后按原规格重新入链表；堆块：释放数据区，头部留作备用
+void MemoryPool::recycle(Chunk* chunk) {
+    Slab* slab = nullptr;
+    if (uses_slabs_) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        slab = find_slab(chunk);
+        if (slab != nullptr) slab->reset_header(chunk);
+    }
+    if (slab == nullptr) {
+        park_header(chunk);
+        return;
+    }
+    note_deallocation(slab->chunk_size());
+    poison_on_free(chunk->data, chunk->capacity);
+    push_global(class_index(slab->chunk_size()), chunk, chunk, 1);
+}
+
+// 获取当前线程绑定到本内存池的缓存
+// 每个线程的缓存只绑定一个内存池（首个使用它的内存池），其他内存池的调用直接走全局链表
+MemoryPool::ThreadCache* MemoryPool::local_cache() {
+    thread_local ThreadCache cache;
+
+    MemoryPool* owner = cache.owner.load(std::memory_order_relaxed);
+    if (owner == this) return &cache;
+    if (owner != nullptr) return nullptr;
+
+    // 首次使用：在注册锁下绑定到本内存池
+    std::lock_guard<std::mutex> lock(cache_registry_mutex());
+    thread_caches_.push_back(&cache);
+    cache.owner.store(this, std::memory_order_relaxed);
+    return &cache;
+}
+
+// 从全局无锁链表弹出最多max_count个块并串成链表，返回链表头，got为实际数量
+Chunk* MemoryPool::pop_global(size_t cls, size_t max_count, size_t& got) {
+    got = 0;
+    Chunk* head = nullptr;
+    while (got < max_count) {
+        Chunk* c = free_lists_[cls].pop();
+        if (c == nullptr) break;
+        c->next = head;
+        head = c;
+        ++got;
+    }
+    note_pop(cls, got);
+    return head;
+}
+
+// 将[head, tail]一段count个块的链表一次性压入全局无锁链表
+// 压入后全局空闲块超过高水位时，超出部分立即归还操作系统
+void MemoryPool::push_global(size_t cls, Chunk* head, Chunk* tail, size_t count) {
+    // 先计数后入链，保证并发取出时计数不会先于入链被扣减
+    size_t now = free_counts_[cls].free.fetch_add(count, std::memory_order_relaxed) + count;
+    free_lists_[cls].push_range(head, tail);
+    size_t high = config_.classes[cls].high_watermark;
+    if (now > high) {
+        trim_class(cls, now - high);
+    }
+}
+
+// 全局空闲链表取出count个块后更新空闲计数，并推低本窗口内的最小空闲块数
+void MemoryPool::note_pop(size_t cls, size_t count) {
+    if (count == 0) return;
+    auto& counter = free_counts_[cls];
+    size_t cur = counter.free.load(std::memory_order_relaxed);
+    size_t next;
+    do {
+        next = cur >= count ? cur - count : 0;
+    } while (!counter.free.compare_exchange_weak(cur, next, std::memory_order_relaxed));
+
+    size_t low = counter.min_free.load(std::memory_order_relaxed);
+    while (next < low &&
+           !counter.min_free.compare_exchange_weak(low, next, std::memory_order_relaxed)) {
+    }
+}
 
-        // 将新链表接入内存池对应规格的链表头部
-        auto it = pool_.find(chunk_size);
-        if (it != pool_.end() && it->second != nullptr) {
-            // 已有链表，将新链表尾部指向原有链表头
-            tail->next = it->second;
-            it->second = head;  // 更新链表头为新链表头
-        } else {
-            // 无原有链表，直接设置新链表为头
-            pool_[chunk_size] = head;
+// 将一段空闲块归还操作系统
+// 堆块：释放数据区，头部留作备用（并发的无锁pop可能仍持有过期的头部指针）
+// slab块：madvise释放物理页后转入idle_slab_chunks_；某个slab的块全部decommit时整体munmap
+size_t MemoryPool::release_chunks(size_t cls, Chunk* list) {
+    std::vector<Chunk*> heap_chunks;
+    size_t n = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& idle = idle_slab_chunks_[cls];
+        std::vector<Slab*> drained;
+        while (list != nullptr) {
+            Chunk* next = list->next;  // 先保存下一个节点，避免释放后指针失效
+            list->next = nullptr;
+            ++n;
+            Slab* slab = slab_index_.empty() ? nullptr : find_slab(list);
+            if (slab == nullptr) {
+                heap_chunks.push_back(list);
+            } else {
+                slab->decommit(list);
+                idle.push_back(list);
+                if (slab->idle_count() == slab->chunk_count()) drained.push_back(slab);
+            }
+            list = next;
         }
 
-        // 更新预分配字节数
-        preallocated_bytes_ += total_size;
+        // 整个slab都已空闲：从idle列表中摘除其块并整体munmap（O(1)）
+        for (Slab* slab : drained) {
+            idle.erase(std::remove_if(idle.begin(), idle.end(),
+                                      [slab](Chunk* c) { return slab->owns(c); }),
+                       idle.end());
+            slab->release();
+        }
     }
+
+    for (Chunk* c : heap_chunks) park_header(c);  // 释放当前内存块数据
+    return n;
+}
+
+// 从全局空闲链表取出最多count个块归还操作系统，返回实际释放的块数
+size_t MemoryPool::trim_class(size_t cls, size_t count) {
+    if (count == 0) return 0;
+    size_t got = 0;
+    Chunk* list = pop_global(cls, count, got);
+    if (list != nullptr) release_chunks(cls, list);
+    return got;
 }
 
-// 查找最匹配的内存块规格（向上取整）
-size_t MemoryPool::find_suitable_size(size_t requested_size) const {
-    for (size_t size : MEM_SIZES) {
-        if (requested_size <= size) return size;
+// 按空闲窗口或强制将各规格的全局空闲块释放到低水位
+size_t MemoryPool::trim(bool force) {
+    int64_t now = steady_now_ns();
+    int64_t start = trim_epoch_ns_.load(std::memory_order_relaxed);
+    if (!force) {
+        int64_t window = static_cast<int64_t>(config_.trim_idle_ms) * 1000000;
+        if (now - start < window) return 0;
     }
-    return 0;  
+    // 开启新窗口（并发调用时只有一个线程执行非强制trim）
+    if (!trim_epoch_ns_.compare_exchange_strong(start, now, std::memory_order_relaxed) && !force) {
+        return 0;
+    }
+
+    size_t released_bytes = 0;
+    bool released_heap = false;
+    for (size_t cls = 0; cls < class_count_; ++cls) {
+        auto& counter = free_counts_[cls];
+        size_t free = counter.free.load(std::memory_order_relaxed);
+        size_t low = config_.classes[cls].low_watermark;
+        // 非强制：只释放整个窗口内都未被取用过的块
+        size_t idle = force ? free : std::min(free, counter.min_free.load(std::memory_order_relaxed));
+        size_t n = free > low ? std::min(idle, free - low) : 0;
+
+        n = trim_class(cls, n);
+        counter.min_free.store(counter.free.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        released_bytes += n * class_sizes_[cls];
+        if (n > 0 && !slab_backed_[cls]) released_heap = true;
+    }
+
+#ifdef __GLIBC__
+    // 堆块的数据区释放后，让glibc将空闲的堆顶/arena归还操作系统
+    if (released_heap) ::malloc_trim(0);
+#endif
+    (void)released_heap;
+    return released_bytes;
+}
+
+size_t MemoryPool::get_free_chunks(size_t chunk_size) const {
+    size_t cls = exact_class_index(chunk_size);
+    if (cls == class_count_) return 0;
+    return free_counts_[cls].free.load(std::memory_order_relaxed);
+}
+
+// 将线程缓存中的全部块归还到全局链表
+void MemoryPool::flush_cache(ThreadCache& cache) {
+    for (size_t cls = 0; cls < cache.mags.size(); ++cls) {
+        auto& mag = cache.mags[cls];
+        if (!mag.head) continue;
+        Chunk* tail = mag.head;
+        while (tail->next) tail = tail->next;
+        push_global(cls, mag.head, tail, mag.count);
+        mag.head = nullptr;
+        mag.count = 0;
+    }
+}
+
+// 当前线程的统计分片：线程首次使用时按轮转分配，之后固定（所有内存池共用同一分片下标）
+MemoryPool::StatShard& MemoryPool::local_shard() {
+    static std::atomic<size_t> next_shard{0};
+    thread_local size_t index = next_shard.fetch_add(1, std::memory_order_relaxed) % STAT_SHARDS;
+    return stat_shards_[index];
 }
 
-// 检查指定大小是否为内存池支持的规格
-bool MemoryPool::is_supported_size(size_t s) const {
-    // 遍历预定义规格，匹配则返回true
-    for (size_t size : MEM_SIZES) {
-        if (s == size) return true;
+// 分配成功后的分片统计（cls == class_count_表示超出最大规格的失败请求，只计入直方图）
+void MemoryPool::note_request(size_t cls, size_t n, bool hit) {
+    StatShard& shard = local_shard();
+    size_t bucket = detail::ceil_log2(n);
+    shard.request_count[bucket].fetch_add(1, std::memory_order_relaxed);
+    shard.request_bytes[bucket].fetch_add(n, std::memory_order_relaxed);
+    if (cls == class_count_) return;
+    shard.allocations.fetch_add(1, std::memory_order_relaxed);
+    (hit ? shard.hits[cls] : shard.misses[cls]).fetch_add(1, std::memory_order_relaxed);
+}
+
+// 从空闲块分配成功后的统计更新：使用量、峰值（全局原子量，精确）与分片计数
+void MemoryPool::note_allocation(size_t cls, size_t n) {
+    size_t bytes = class_sizes_[cls];
+    size_t now = current_usage_bytes_.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    note_request(cls, n, true);
+    update_peak(now);
+}
+
+void MemoryPool::note_failure() {
+    local_shard().failures.fetch_add(1, std::memory_order_relaxed);
+}
+
+// 用CAS将峰值推高到usage（仅在更大时写入）
+void MemoryPool::update_peak(size_t usage) {
+    size_t peak = peak_usage_bytes_.load(std::memory_order_relaxed);
+    while (usage > peak &&
+           !peak_usage_bytes_.compare_exchange_weak(peak, usage, std::memory_order_relaxed)) {
     }
-    return false;
+}
+
+// 归还后的统计更新（防止下溢，最小为0）
+void MemoryPool::note_deallocation(size_t bytes) {
+    size_t cur = current_usage_bytes_.load(std::memory_order_relaxed);
+    size_t next;
+    do {
+        next = cur >= bytes ? cur - bytes : 0;
+    } while (!current_usage_bytes_.compare_exchange_weak(cur, next, std::memory_order_relaxed));
+    local_shard().deallocations.fetch_add(1, std::memory_order_relaxed);
 }
 
 // 分配指定大小的内存块
-// 核心逻辑：优先从预分配链表取（快路径），无则新建，全程保证线程安全
+// 核心逻辑：线程缓存（无锁快路径）→ 全局链表批量补充 → 新建，全程保证线程安全
 Chunk* MemoryPool::alloc_chunk(size_t n) {
     // 无效请求直接返回nullptr
     if (n == 0) return nullptr;
 
     // 找到匹配的内存块规格
-    size_t chunk_size = find_suitable_size(n);
-    if (chunk_size == 0) {
+    size_t cls = class_index(n);
+    if (cls == class_count_) {
         // 无匹配规格，更新失败统计并返回nullptr
-        std::lock_guard<std::mutex> lock(mutex_);
-        stats_.allocation_failures++;
+        note_request(cls, n, false);
+        note_failure();
         return nullptr;
     }
-
-    // 快路径：加锁从预分配链表取现成的内存块（最常用场景）
-    {
-        std::lock_guard<std::mutex> lock(mutex_);
-        auto it = pool_.find(chunk_size);
-        if (it != pool_.end() && it->second != nullptr) {
-            // 取出链表头节点
-            Chunk* chunk = it->second;
-            it->second = chunk->next;  // 更新链表头为下一个节点
-            chunk->next = nullptr;     // 清空取出节点的next指针
-
-            // 更新使用量和统计信息
-            current_usage_bytes_ += chunk_size;
-            stats_.total_allocations++;
-            stats_.current_usage_bytes = current_usage_bytes_;
-            // 更新峰值使用量
-            if (current_usage_bytes_ > stats_.peak_usage_bytes) {
-                stats_.peak_usage_bytes = current_usage_bytes_;
-            }
-            return chunk;  // 成功分配，返回内存块
+    size_t chunk_size = class_sizes_[cls];
+
+    // 快路径：从线程缓存取（无锁），缓存为空时从全局链表批量补充
+    ThreadCache* cache = cache_limits_[cls] > 0 ? local_cache() : nullptr;
+    if (cache) {
+        auto& mag = cache->mags[cls];
+        if (mag.head == nullptr) {
+            mag.head = pop_global(cls, cache_batches_[cls], mag.count);
+        }
+        if (mag.head != nullptr) {
+            Chunk* chunk = mag.head;
+            mag.head = chunk->next;
+            mag.count--;
+            chunk->next = nullptr;
+            note_allocation(cls, n);
+            poison_on_alloc(chunk->data, chunk->capacity);
+            return chunk;
+        }
+    } else {
+        // 无线程缓存（大规格或线程已绑定其他内存池）：直接从全局无锁链表取单个块
+        Chunk* chunk = free_lists_[cls].pop();
+        if (chunk != nullptr) {
+            note_pop(cls, 1);
+            note_allocation(cls, n);
+            poison_on_alloc(chunk->data, chunk->capacity);
+            return chunk;
         }
+    }
 
-        // 预分配链表无可用节点，先检查是否超出最大容量
-        if (current_usage_bytes_ + chunk_size > max_capacity_bytes_) {
-            stats_.allocation_failures++;
+    // 慢路径：无可用节点，先预占容量（CAS保证多线程下不超出最大容量）
+    size_t cur = current_usage_bytes_.load(std::memory_order_relaxed);
+    do {
+        if (cur + chunk_size > max_capacity_bytes_.load(std::memory_order_relaxed)) {
+            note_failure();
             throw MemoryPoolExhaustedError("Allocation would exceed maximum pool capacity");
         }
-        // 释放锁，后续在锁外创建新内存块（减少锁持有时间）
-    }
+    } while (!current_usage_bytes_.compare_exchange_weak(cur, cur + chunk_size,
+                                                         std::memory_order_relaxed));
 
-    // 慢路径：预分配无可用节点，锁外创建新内存块
+    // 锁外创建新内存块
     Chunk* new_chunk = nullptr;
     try {
-        new_chunk = new Chunk(chunk_size);
+        new_chunk = make_chunk(chunk_size);
     } catch (const std::bad_alloc&) {
-        // 系统内存不足，更新失败统计并抛出异常
-        std::lock_guard<std::mutex> lock(mutex_);
-        stats_.allocation_failures++;
+        // 系统内存不足，回滚预占容量、更新失败统计并抛出异常
+        current_usage_bytes_.fetch_sub(chunk_size, std::memory_order_relaxed);
+        note_failure();
         throw MemoryAllocationError("Failed to allocate chunk of size: " + std::to_string(chunk_size));
     }
 
-    // 再次加锁，二次校验容量（防止多线程竞态导致超出容量）
-    {
-        std::lock_guard<std::mutex> lock(mutex_);
-        if (current_usage_bytes_ + chunk_size > max_capacity_bytes_) {
-            // 超出容量，回滚：删除刚创建的内存块
-            delete new_chunk;
-            stats_.allocation_failures++;
-            throw MemoryPoolExhaustedError("Allocation would exceed maximum pool capacity (after recheck)");
-        }
-
-        // 成功：更新使用量和统计信息
-        current_usage_bytes_ += chunk_size;
-        stats_.total_allocations++;
-        stats_.current_usage_bytes = current_usage_bytes_;
-        if (current_usage_bytes_ > stats_.peak_usage_bytes) {
-            stats_.peak_usage_bytes = current_usage_bytes_;
-        }
-    }
-
+    // 成功：容量已预占，这里只更新次数（计为未命中）与峰值
+    note_request(cls, n, false);
+    update_peak(cur + chunk_size);
+    poison_on_alloc(new_chunk->data, new_chunk->capacity);
     return new_chunk;
 }
 
@@ -213,50 +725,86 @@ void MemoryPool::retrieve(Chunk* chunk) {
     if (!chunk) return;
 
     size_t chunk_size = chunk->capacity;
-    // 容量为0的无效内存块直接释放
-    if (chunk_size == 0) {
-        delete chunk;
-        return;
-    }
-
-    // 非内存池支持的规格，直接释放（防止混入非法规格内存块）
-    if (!is_supported_size(chunk_size)) {
-        delete chunk;
+    // 容量为0、非内存池支持的规格（如被expand_capacity扩容过），
+    // 或slab承载的规格中数据区不在slab中的块：按来源回收
+    size_t cls = chunk_size == 0 ? class_count_ : exact_class_index(chunk_size);
+    if (cls == class_count_ ||
+        (slab_backed_[cls] && chunk->owns_data)) {
+        recycle(chunk);
         return;
     }
 
     // 清空内存块数据（根据Chunk::clear()实现，如重置数据指针、长度等）
     chunk->clear();
+    note_deallocation(chunk_size);
+    poison_on_free(chunk->data, chunk_size);
+
+    // 快路径：放入线程缓存（无锁），超出上限时将一批块溢出到全局链表
+    ThreadCache* cache = cache_limits_[cls] > 0 ? local_cache() : nullptr;
+    if (cache) {
+        auto& mag = cache->mags[cls];
+        chunk->next = mag.head;
+        mag.head = chunk;
+        if (++mag.count > cache_limits_[cls]) {
+            // 摘下前cache_batch个块一次性归还
+            Chunk* head = mag.head;
+            Chunk* tail = head;
+            for (size_t i = 1; i < cache_batches_[cls]; ++i) tail = tail->next;
+            mag.head = tail->next;
+            mag.count -= cache_batches_[cls];
+            push_global(cls, head, tail, cache_batches_[cls]);
+        }
+        return;
+    }
 
-    // 加锁保证线程安全，将内存块归还到对应规格的链表头部
-    std::lock_guard<std::mutex> lock(mutex_);
+    // 无线程缓存：直接压入全局无锁链表
+    push_global(cls, chunk, chunk, 1);
+}
 
-    auto it = pool_.find(chunk_size);
-    if (it != pool_.end()) {
-        // 头插法：将归还的内存块插入链表头部
-        chunk->next = it->second;
-        it->second = chunk;
-    } else {
-        // 理论上不会走到这里（构造时已预置所有规格的key），做兜底处理
-        chunk->next = nullptr;
-        pool_[chunk_size] = chunk;
+// 获取内存池统计信息（按值返回，合并各分片的计数；并发更新时各计数之间可能略有先后）
+PoolStats MemoryPool::get_stats() const {
+    PoolStats stats;
+    stats.peak_usage_bytes = peak_usage_bytes_.load(std::memory_order_relaxed);
+    stats.current_usage_bytes = current_usage_bytes_.load(std::memory_order_relaxed);
+    stats.classes.resize(class_count_);
+    for (size_t cls = 0; cls < class_count_; ++cls) {
+        stats.classes[cls].size = class_sizes_[cls];
     }
-
-    // 更新当前使用量（防止下溢，最小为0）
-    if (current_usage_bytes_ >= chunk_size) {
-        current_usage_bytes_ -= chunk_size;
-    } else {
-        current_usage_bytes_ = 0;
+    std::array<size_t, REQUEST_HISTOGRAM_BUCKETS> counts{};
+    std::array<size_t, REQUEST_HISTOGRAM_BUCKETS> bytes{};
+
+    for (const auto& shard : stat_shards_) {
+        stats.total_allocations += shard.allocations.load(std::memory_order_relaxed);
+        stats.total_deallocations += shard.deallocations.load(std::memory_order_relaxed);
+        stats.allocation_failures += shard.failures.load(std::memory_order_relaxed);
+        for (size_t cls = 0; cls < class_count_; ++cls) {
+            stats.classes[cls].hits += shard.hits[cls].load(std::memory_order_relaxed);
+            stats.classes[cls].misses += shard.misses[cls].load(std::memory_order_relaxed);
+        }
+        for (size_t k = 0; k < REQUEST_HISTOGRAM_BUCKETS; ++k) {
+            counts[k] += shard.request_count[k].load(std::memory_order_relaxed);
+            bytes[k] += shard.request_bytes[k].load(std::memory_order_relaxed);
+        }
     }
 
-    // 更新统计信息
-    stats_.current_usage_bytes = current_usage_bytes_;
-    stats_.total_deallocations++;
+    // 第k桶的请求全部由log2_class_[k]规格服务，据此汇总各规格的请求/交付字节数
+    for (size_t k = 0; k < REQUEST_HISTOGRAM_BUCKETS; ++k) {
+        if (counts[k] == 0) continue;
+        size_t cls = log2_class_[k];
+        RequestSizeBucket bucket;
+        bucket.max_request = k < 64 ? (size_t{1} << k) : SIZE_MAX;
+        bucket.served_size = cls < class_count_ ? class_sizes_[cls] : 0;
+        bucket.count = counts[k];
+        bucket.requested_bytes = bytes[k];
+        stats.request_histogram.push_back(bucket);
+    }
+    for (size_t cls = 0; cls < class_count_; ++cls) {
+        auto& c = stats.classes[cls];
+        c.served_bytes = (c.hits + c.misses) * c.size;
+    }
+    for (const auto& bucket : stats.request_histogram) {
+        if (bucket.served_size == 0) continue;
+        stats.classes[exact_class_index(bucket.served_size)].requested_bytes += bucket.requested_bytes;
+    }
+    return stats;
 }
-
-// 获取内存池统计信息（按值返回，保证线程安全）
-PoolStats MemoryPool::get_stats() const {
-    // 加锁保证读取的统计信息是完整、一致的
-    std::lock_guard<std::mutex> lock(mutex_);
-    return stats_;
-}
\ No newline at end of file
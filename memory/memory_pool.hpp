@@ -1,8 +1,8 @@
 #ifndef MEMORY_POOL_HPP
 #define MEMORY_POOL_HPP
 
-#include <unordered_map>  
 #include <mutex>           
+#include <atomic>          
 #include <array>         
 #include <vector>         
 #include <memory>         
@@ -10,7 +10,11 @@
 #include <cstddef>        
 #include <cstdint>         
 #include <algorithm>       
+#include <map>             
 #include "chunk.hpp"       
+#include "slab.hpp"        
+
+class SmallObjectHeap;
 
 // 内存分配错误异常类 - 继承自标准运行时异常
 // 用于表示内存分配过程中出现的错误（如参数非法等）
@@ -30,7 +34,7 @@ public:
         : std::runtime_error(msg) {}
 };
 
-// 预定义的内存块规格数组（单位：字节）
+// 默认的内存块规格数组（单位：字节），PoolConfig未指定规格表时使用
 constexpr std::array<size_t, 6> MEM_SIZES = {
     4096,                // 4K - 基础规格
     4096 * 4,            // 16K
@@ -40,6 +44,162 @@ constexpr std::array<size_t, 6> MEM_SIZES = {
     4096 * 1024          // 4M - 最大预设规格
 };
 
+constexpr size_t MAX_SIZE_CLASSES = 16;     // 规格表最多包含的规格数
+constexpr size_t MIN_CLASS_SIZE = 64;       // 最小规格（字节）
+
+namespace detail {
+    // 向上取整的log2（n <= 1时为0）
+    constexpr size_t ceil_log2(size_t n) {
+        return n <= 1 ? 0 : 64 - static_cast<size_t>(__builtin_clzll(static_cast<unsigned long long>(n - 1)));
+    }
+}
+static_assert(detail::ceil_log2(1) == 0 && detail::ceil_log2(4096) == 12 && detail::ceil_log2(4097) == 13,
+              "ceil_log2");
+
+// 无锁空闲链表（Treiber栈），以Chunk::next串接
+// ABA防护：头指针低48位存放指针，高16位存放版本号，每次成功CAS版本号+1
+// 前提：链表中出现过的Chunk头部在内存池存活期间不被释放（见MemoryPool::spare_headers_），
+//       因此并发pop读取到过期节点的next时不会访问已释放内存，随后的CAS也会因版本号变化而失败
+class alignas(64) FreeList {
+public:
+    // 将[head, tail]一段已串好的链表整体压栈（一次CAS）
+    void push_range(Chunk* head, Chunk* tail) {
+        uint64_t old = head_.load(std::memory_order_relaxed);
+        do {
+            tail->next = unpack(old);
+        } while (!head_.compare_exchange_weak(old, pack(head, tag(old) + 1),
+                                              std::memory_order_release,
+                                              std::memory_order_relaxed));
+    }
+
+    void push(Chunk* c) { push_range(c, c); }
+
+    // 弹出一个节点，空栈返回nullptr
+    Chunk* pop() {
+        uint64_t old = head_.load(std::memory_order_acquire);
+        while (true) {
+            Chunk* top = unpack(old);
+            if (top == nullptr) return nullptr;
+            Chunk* next = top->next;
+            if (head_.compare_exchange_weak(old, pack(next, tag(old) + 1),
+                                            std::memory_order_acquire,
+                                            std::memory_order_acquire)) {
+                top->next = nullptr;
+                return top;
+            }
+        }
+    }
+
+    // 一次性摘下整个链表（用于清空）
+    Chunk* pop_all() {
+        uint64_t old = head_.load(std::memory_order_acquire);
+        while (!head_.compare_exchange_weak(old, pack(nullptr, tag(old) + 1),
+                                            std::memory_order_acquire,
+                                            std::memory_order_acquire)) {
+        }
+        return unpack(old);
+    }
+
+private:
+    static_assert(sizeof(void*) == 8, "FreeList tagged pointer requires 64-bit pointers");
+    static constexpr uint64_t PTR_MASK = (uint64_t{1} << 48) - 1;
+
+    static uint64_t pack(Chunk* p, uint64_t t) {
+        return (reinterpret_cast<uint64_t>(p) & PTR_MASK) | (t << 48);
+    }
+    static Chunk* unpack(uint64_t v) { return reinterpret_cast<Chunk*>(v & PTR_MASK); }
+    static uint64_t tag(uint64_t v) { return v >> 48; }
+
+    std::atomic<uint64_t> head_{0};
+};
+
+// 线程本地缓存（magazine）参数
+// 每个线程为每种规格缓存少量空闲块，常规分配/归还无需加锁；
+// 缓存满/空时按批次与全局空闲链表交换，大规格缓存上限为0（直接走全局链表）
+constexpr size_t THREAD_CACHE_BYTES_PER_CLASS = 256 * 1024;  // 每种规格线程缓存的字节上限
+constexpr size_t THREAD_CACHE_MAX_CHUNKS = 64;               // 每种规格线程缓存的块数上限
+
+// 内存块数据区的承载方式
+enum class ChunkBacking {
+    kHeap,   // 每个块的数据区单独new char[]（默认）
+    kSlab    // 同规格块的数据区从大块连续mmap slab中切分，头部集中存放在稠密数组
+};
+
+// 单个规格的配置
+struct SizeClassSpec {
+    size_t size;             // 块大小（字节，2的幂，不小于MIN_CLASS_SIZE）
+    size_t warm_up;          // 构造时预分配的块数
+    size_t low_watermark;    // trim()最多释放到的全局空闲块数
+    size_t high_watermark;   // 归还后全局空闲块超过此数时，超出部分立即归还操作系统（slab承载的规格至少为low_watermark + 每slab块数）
+};
+
+// 内存池构造参数
+struct PoolConfig {
+    ChunkBacking backing = ChunkBacking::kHeap;  // 数据区承载方式
+    size_t slab_bytes = 2 * 1024 * 1024;         // slab目标大小（slab承载的规格，至少容纳一个块）
+    // 数据区优先放置的NUMA节点（-1表示不指定）：kSlab模式下对每个slab调用mbind；
+    // kHeap模式依赖首次访问策略（数据区不清零，由使用该池的线程首次写入），在IO线程内构造即可本地化
+    int numa_node = -1;
+    // 大规格的大页承载：不小于huge_page_min_size的规格改由slab承载（与backing无关）并按该策略映射，
+    // 每个slab的数据区按slab_bytes（默认2MB，即一个大页）映射；大页不可用时退化为普通页
+    HugePageMode huge_pages = HugePageMode::kNone;
+    size_t huge_page_min_size = 256 * 1024;
+
+    // 规格表（按块大小严格递增，最多MAX_SIZE_CLASSES项），请求大小向上取整到第一个不小于它的规格
+    // 水位只统计全局空闲链表，不含线程缓存中的块
+    std::vector<SizeClassSpec> classes = default_classes();
+    size_t trim_idle_ms = 30000;  // 空闲窗口：trim()只释放在整个窗口内都未被取用过的空闲块
+
+    // 默认规格表：4K起每级4倍，直到4M
+    static std::vector<SizeClassSpec> default_classes() {
+        return {
+            {MEM_SIZES[0], 200, 200, 1024},
+            {MEM_SIZES[1],  50,  50,  256},
+            {MEM_SIZES[2],  20,  20,   64},
+            {MEM_SIZES[3],  10,  10,   32},
+            {MEM_SIZES[4],   5,   5,   16},
+            {MEM_SIZES[5],   2,   2,    4},
+        };
+    }
+
+    // 细粒度规格表：512B/1K/2K/4K/8K覆盖小消息，其后与默认规格表一致
+    static std::vector<SizeClassSpec> fine_grained_classes() {
+        return {
+            {512,          256, 256, 2048},
+            {1024,         256, 256, 1024},
+            {2048,         128, 128,  512},
+            {4096,         128, 128,  512},
+            {8192,          64,  64,  256},
+            {MEM_SIZES[1],  32,  32,  128},
+            {MEM_SIZES[2],  16,  16,   64},
+            {MEM_SIZES[3],   8,   8,   32},
+            {MEM_SIZES[4],   4,   4,   16},
+            {MEM_SIZES[5],   2,   2,    4},
+        };
+    }
+};
+
+// 统计计数按线程分片（每个线程固定写入一个分片，分片独占缓存行），读取时合并，分配/归还路径无锁且几乎无竞争
+constexpr size_t STAT_SHARDS = 16;               // 统计分片数
+constexpr size_t REQUEST_HISTOGRAM_BUCKETS = 65; // 请求大小直方图桶数：第k桶统计(2^(k-1), 2^k]字节的请求
+
+// 单个规格的统计
+struct SizeClassStats {
+    size_t size = 0;             // 规格大小
+    size_t hits = 0;             // 从空闲块（线程缓存或全局空闲链表）取得的次数
+    size_t misses = 0;           // 空闲块耗尽、需新建内存块的次数
+    size_t requested_bytes = 0;  // 落在该规格的请求字节数之和
+    size_t served_bytes = 0;     // 实际交付的字节数之和（分配次数 × 规格大小），与requested_bytes之差即内部碎片
+};
+
+// 请求大小直方图的一个桶：请求大小落在(max_request/2, max_request]内，由served_size规格服务
+struct RequestSizeBucket {
+    size_t max_request = 0;      // 桶上界（2的幂）
+    size_t served_size = 0;      // 服务该桶的规格大小，0表示超出最大规格、无法分配
+    size_t count = 0;            // 请求次数
+    size_t requested_bytes = 0;  // 请求字节数之和
+};
+
 // 内存池统计信息结构体
 // 用于记录内存池的使用状态和性能指标
 struct PoolStats {
@@ -48,25 +208,38 @@ struct PoolStats {
     size_t peak_usage_bytes = 0;       // 峰值使用字节数
     size_t current_usage_bytes = 0;    // 当前使用字节数
     size_t allocation_failures = 0;    // 分配失败次数
+
+    std::vector<SizeClassStats> classes;              // 各规格的命中/未命中与碎片统计（按规格顺序）
+    std::vector<RequestSizeBucket> request_histogram; // 请求大小直方图（只含非空桶，按大小递增）
 };
 
-// 内存池核心类 - 采用单例模式实现
+// 内存池核心类 - 默认通过单例使用，也可按PoolConfig构造独立实例
 // 管理不同规格的预分配内存块，提供高效的内存分配/释放功能
 class MemoryPool {
 public:
+    // 构造独立的内存池（构造时即选定数据区承载方式与规格表），规格表非法时抛出std::invalid_argument
+    explicit MemoryPool(const PoolConfig& config);
+
     MemoryPool(const MemoryPool&) = delete;
     MemoryPool& operator=(const MemoryPool&) = delete;
     MemoryPool(MemoryPool&&) = delete;
     MemoryPool& operator=(MemoryPool&&) = delete;
 
     static MemoryPool& get_instance() {
-        static MemoryPool instance;  // 静态局部变量，保证只初始化一次
+        static MemoryPool instance{instance_config()};  // 静态局部变量，保证只初始化一次
         return instance;
     }
 
+    // 设置单例的构造参数，必须在首次get_instance()之前调用
+    // 单例已创建时抛出std::logic_error，规格表非法时抛出std::invalid_argument
+    static void configure(const PoolConfig& config);
+
+    // 校验规格表：非空、不超过MAX_SIZE_CLASSES项、严格递增、均为不小于MIN_CLASS_SIZE的2的幂
+    static void validate(const PoolConfig& config);
+
     // 核心方法：分配指定字节数的内存块
     Chunk* alloc_chunk(size_t n);
-    Chunk* alloc_chunk() { return alloc_chunk(MEM_SIZES[0]); }
+    Chunk* alloc_chunk() { return alloc_chunk(class_sizes_[0]); }
 
     // 核心方法：将内存块归还到内存池
     void retrieve(Chunk* chunk);
@@ -78,43 +251,131 @@ public:
 
     // 设置内存池最大容量（字节数）
     void set_max_capacity(size_t max_bytes) {
-        std::lock_guard<std::mutex> lock(mutex_);
-        max_capacity_bytes_ = max_bytes;
+        max_capacity_bytes_.store(max_bytes, std::memory_order_relaxed);
     }
 
     // 获取当前内存使用量（字节数）
     size_t get_current_usage() const {
-        std::lock_guard<std::mutex> lock(mutex_);
-        return current_usage_bytes_;
+        return current_usage_bytes_.load(std::memory_order_relaxed);
     }
 
     // 获取内存池最大容量（字节数）
     size_t get_max_capacity() const {
-        std::lock_guard<std::mutex> lock(mutex_);
-        return max_capacity_bytes_;
+        return max_capacity_bytes_.load(std::memory_order_relaxed);
     }
 
     // 清空内存池 - 释放所有预分配的内存块
+    // 注意：仅回收全局链表与当前线程的缓存，其他线程缓存中的块在其线程退出时归还
+    //       kSlab模式下以slab为单位整体归还（O(1) munmap），仍有块在使用中的slab保留
     void clear();
 
+    // 将空闲内存归还操作系统，返回释放的字节数
+    // force=false：距上次trim不足trim_idle_ms时直接返回0；否则各规格释放整个窗口内都未被取用过的空闲块，
+    //              最多释放到低水位（适合由定时器周期调用）
+    // force=true ：立即将各规格全局空闲块释放到低水位
+    // 堆块释放数据区；slab块madvise(MADV_DONTNEED)释放物理页，整个slab都空闲时整体munmap
+    size_t trim(bool force = false);
+
+    // 指定规格的全局空闲块数（不含线程缓存中的块）
+    size_t get_free_chunks(size_t chunk_size) const;
+
+    // 规格表查询
+    size_t class_count() const { return class_count_; }
+    size_t class_size(size_t cls) const { return class_sizes_[cls]; }
+    size_t max_chunk_size() const { return class_sizes_[class_count_ - 1]; }
+    // 请求大小n对应的规格下标（O(1)查表），超出最大规格返回class_count()
+    size_t class_index(size_t n) const { return log2_class_[detail::ceil_log2(n)]; }
+    // 与chunk_size完全相等的规格下标，不是本内存池的规格返回class_count()
+    size_t exact_class_index(size_t chunk_size) const {
+        size_t cls = class_index(chunk_size);
+        return (cls < class_count_ && class_sizes_[cls] == chunk_size) ? cls : class_count_;
+    }
+
+    // 获取构造参数
+    const PoolConfig& config() const { return config_; }
+
+    // 当前由大页承载的slab数据区总字节数（huge_pages为kNone或大页不可用时为0）
+    size_t get_huge_page_bytes();
+
+    // 本内存池的小对象堆（PoolAllocator/PoolMemoryResource的小请求从这里切分，见pool_allocator.hpp）
+    SmallObjectHeap& small_objects() { return *small_objects_; }
+
 private:
-    // 私有构造函数 
-    MemoryPool();
+    struct ThreadCache;  // 线程本地缓存（定义见memory_pool.cpp）
 
+    static PoolConfig instance_config();                       // 取出单例的构造参数并标记单例已创建
+    void build_class_table();                                  // 按config_构建规格表与O(1)查找表
     void initialize_pool();                                    // 初始化内存池 - 内部初始化逻辑
     void preallocate_chunks(size_t chunk_size, size_t count);  // 预分配指定规格和数量的内存块
-    size_t find_suitable_size(size_t requested_size) const;    // 根据请求的大小，找到最匹配的预定义规格（向上取整）
-    bool is_supported_size(size_t s) const;                    // 检查指定大小是否是内存池支持的规格
+    Chunk* make_chunk(size_t chunk_size);                      // 新建内存块（优先复用备用头部，slab承载的规格新建slab）
+    void park_header(Chunk* chunk);                            // 释放内存块数据，头部留作备用
+    Chunk* grow_slabs(size_t cls, size_t count);               // 新建/重新映射slab直到至少容纳count个块，返回其中一个块，其余入空闲链表
+    Slab* find_slab(const Chunk* chunk);                       // 查找头部所属的slab（需持有mutex_）
+    void recycle(Chunk* chunk);                                // 按块的来源回收（slab头部入空闲链表，堆块释放数据区）
+    size_t release_chunks(size_t cls, Chunk* list);            // 将一段空闲块归还操作系统，返回块数
+    size_t trim_class(size_t cls, size_t count);               // 从全局空闲链表取出最多count个块归还操作系统
+
+    ThreadCache* local_cache();                                // 获取绑定到本内存池的当前线程缓存（未绑定则尝试绑定）
+    Chunk* pop_global(size_t cls, size_t max_count, size_t& got);  // 从全局无锁链表批量取块
+    void push_global(size_t cls, Chunk* head, Chunk* tail, size_t count);  // 将count个块的一段链表归还到全局无锁链表（超过高水位时裁剪）
+    void note_pop(size_t cls, size_t count);                   // 全局空闲链表取出count个块后更新空闲计数
+    void flush_cache(ThreadCache& cache);                      // 将线程缓存全部归还到全局链表
+    void release_free_lists();                                 // 释放全局链表中的所有块并重置状态
+    struct StatShard;
+    StatShard& local_shard();                                  // 当前线程写入的统计分片
+    void note_request(size_t cls, size_t n, bool hit);         // 分配成功后的分片统计：次数、命中/未命中、请求直方图
+    void note_allocation(size_t cls, size_t n);                // 从空闲块分配成功后的统计更新（无锁）
+    void note_deallocation(size_t bytes);                      // 归还后的统计更新（无锁）
+    void note_failure();                                       // 分配失败计数（无锁）
+    void update_peak(size_t usage);                            // 更新峰值使用量
 
 private:
-    // 内存池映射类型定义：键=内存块大小，值=该规格的内存块链表头指针
-    using PoolMap = std::unordered_map<size_t, Chunk*>;
-    PoolMap pool_;                  // 存储不同规格内存块的核心容器
-    mutable std::mutex mutex_;      // 互斥锁，保证线程安全（mutable允许const方法修改）
-    size_t max_capacity_bytes_;     // 内存池最大容量（字节）
-    size_t current_usage_bytes_;    // 当前已使用字节数
-    size_t preallocated_bytes_;     // 预分配的总字节数
-    PoolStats stats_;               // 内存池运行时统计信息
+    PoolConfig config_;             // 构造参数
+
+    // 规格表（构造后不变）
+    size_t class_count_{0};
+    std::array<size_t, MAX_SIZE_CLASSES> class_sizes_{};
+    std::array<size_t, MAX_SIZE_CLASSES> cache_limits_{};   // 各规格线程缓存上限（块数），0表示不做线程缓存
+    std::array<size_t, MAX_SIZE_CLASSES> cache_batches_{};  // 各规格与全局链表交换的批量大小
+    std::array<uint8_t, 65> log2_class_{};                  // ceil_log2(n) -> 第一个不小于2^k的规格下标
+    std::array<bool, MAX_SIZE_CLASSES> slab_backed_{};      // 各规格是否由slab承载（kSlab模式或大页规格）
+    std::array<HugePageMode, MAX_SIZE_CLASSES> class_huge_{};  // 各规格slab的大页策略
+    bool uses_slabs_{false};                                // 是否有任一规格由slab承载
+
+    std::array<FreeList, MAX_SIZE_CLASSES> free_lists_;  // 按规格下标索引的无锁空闲链表
+
+    // 各规格全局空闲块计数（近似值，独占缓存行避免伪共享）
+    struct alignas(64) FreeCounter {
+        std::atomic<size_t> free{0};      // 当前全局空闲块数
+        std::atomic<size_t> min_free{0};  // 本次trim窗口内的最小空闲块数（窗口内从未被取用的块数）
+    };
+    std::array<FreeCounter, MAX_SIZE_CLASSES> free_counts_;
+    std::atomic<int64_t> trim_epoch_ns_{0};  // 当前trim窗口的起始时间（steady_clock）
+    std::mutex mutex_;              // 互斥锁，仅保护慢路径：备用头部、slab列表与预分配计数
+    std::vector<Chunk*> spare_headers_;          // 已释放数据的Chunk头部，新建时复用，析构时才真正delete
+    std::array<std::vector<std::unique_ptr<Slab>>, MAX_SIZE_CLASSES> slabs_;  // 各规格的slab（slab承载的规格）
+    std::map<const Chunk*, Slab*> slab_index_;   // 头部数组起始地址 -> slab，用于按头部反查所属slab
+    std::array<std::vector<Chunk*>, MAX_SIZE_CLASSES> idle_slab_chunks_;  // 已decommit的slab块（不在空闲链表中），新建时优先复用
+    std::atomic<size_t> max_capacity_bytes_;     // 内存池最大容量（字节）
+    std::atomic<size_t> current_usage_bytes_;    // 当前已使用字节数（已交给调用方、尚未归还的字节数）
+    size_t preallocated_bytes_;     // 预分配的总字节数（受mutex_保护）
+
+    // 运行时统计：使用量与峰值为全局原子量（容量限制需要精确值），其余计数按线程分片，读取时合并为PoolStats
+    std::atomic<size_t> peak_usage_bytes_{0};
+    struct alignas(64) StatShard {
+        std::atomic<size_t> allocations{0};
+        std::atomic<size_t> deallocations{0};
+        std::atomic<size_t> failures{0};
+        std::array<std::atomic<size_t>, MAX_SIZE_CLASSES> hits{};
+        std::array<std::atomic<size_t>, MAX_SIZE_CLASSES> misses{};
+        std::array<std::atomic<size_t>, REQUEST_HISTOGRAM_BUCKETS> request_count{};
+        std::array<std::atomic<size_t>, REQUEST_HISTOGRAM_BUCKETS> request_bytes{};
+    };
+    std::array<StatShard, STAT_SHARDS> stat_shards_;
+
+    std::vector<ThreadCache*> thread_caches_;  // 绑定到本内存池的线程缓存（受全局缓存注册锁保护）
+
+    std::unique_ptr<SmallObjectHeap> small_objects_;
 };
 
 #endif // MEMORY_POOL_HPP
\ No newline at end of file
@@ -0,0 +1,32 @@
+#include "numa.hpp"
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+    constexpr int MPOL_PREFERRED_MODE = 1;        // <linux/mempolicy.h>中的MPOL_PREFERRED
+    constexpr unsigned long MAX_NUMA_NODES = 64;  // 节点掩码只用一个unsigned long
+}
+
+int current_numa_node() {
+#ifdef SYS_getcpu
+    unsigned cpu = 0;
+    unsigned node = 0;
+    if (::syscall(SYS_getcpu, &cpu, &node, nullptr) == 0) {
+        return static_cast<int>(node);
+    }
+#endif
+    return -1;
+}
+
+bool bind_to_numa_node(void* addr, size_t len, int node) {
+#ifdef SYS_mbind
+    if (addr == nullptr || len == 0 || node < 0 || static_cast<unsigned long>(node) >= MAX_NUMA_NODES) {
+        return false;
+    }
+    unsigned long mask = 1UL << node;
+    return ::syscall(SYS_mbind, addr, len, MPOL_PREFERRED_MODE, &mask, MAX_NUMA_NODES + 1, 0) == 0;
+#else
+    (void)addr; (void)len; (void)node;
+    return false;
+#endif
+}
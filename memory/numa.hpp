@@ -0,0 +1,16 @@
+#ifndef NUMA_HPP
+#define NUMA_HPP
+
+#include <cstddef>
+
+// NUMA辅助函数：直接使用getcpu/mbind系统调用，不依赖libnuma
+// 单节点机器或内核不支持时均退化为无操作，不影响正确性
+
+// 当前线程所在CPU的NUMA节点，获取失败返回-1
+int current_numa_node();
+
+// 将[addr, addr+len)的页面放置策略设为优先node节点（MPOL_PREFERRED），需在首次写入前调用
+// node < 0 或调用失败时返回false，页面按默认的首次访问策略分配
+bool bind_to_numa_node(void* addr, size_t len, int node);
+
+#endif // NUMA_HPP
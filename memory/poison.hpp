@@ -0,0 +1,66 @@
+#ifndef POISON_HPP
+#define POISON_HPP
+
+#include <cstddef>
+#include <cstring>
+
+// 内存块数据区的调试毒化（编译时定义AZH_MEMORY_POISON启用，默认关闭且零开销）
+// - 交给调用方的数据区填充0xCD：暴露对未初始化数据的依赖（数据区不再零初始化）
+// - 归还到内存池的数据区填充0xDD：暴露归还后继续使用
+// - AddressSanitizer构建下，空闲块的数据区额外标记为不可访问，越界/释放后访问直接报错
+
+#if defined(__SANITIZE_ADDRESS__)
+#define AZH_HAS_ASAN 1
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define AZH_HAS_ASAN 1
+#endif
+#endif
+
+#if defined(AZH_MEMORY_POISON) && defined(AZH_HAS_ASAN)
+#include <sanitizer/asan_interface.h>
+#endif
+
+constexpr unsigned char POISON_ALLOC_BYTE = 0xCD;  // 已分配但未写入
+constexpr unsigned char POISON_FREE_BYTE = 0xDD;   // 已归还
+
+// 数据区交给调用方前调用
+inline void poison_on_alloc(char* data, size_t len) {
+#ifdef AZH_MEMORY_POISON
+    if (data == nullptr || len == 0) return;
+#ifdef AZH_HAS_ASAN
+    ASAN_UNPOISON_MEMORY_REGION(data, len);
+#endif
+    std::memset(data, POISON_ALLOC_BYTE, len);
+#else
+    (void)data;
+    (void)len;
+#endif
+}
+
+// 数据区归还到空闲链表/线程缓存时调用
+inline void poison_on_free(char* data, size_t len) {
+#ifdef AZH_MEMORY_POISON
+    if (data == nullptr || len == 0) return;
+    std::memset(data, POISON_FREE_BYTE, len);
+#ifdef AZH_HAS_ASAN
+    ASAN_POISON_MEMORY_REGION(data, len);
+#endif
+#else
+    (void)data;
+    (void)len;
+#endif
+}
+
+// 数据区交还操作系统（delete[]/munmap）前调用，清除ASan标记，避免地址复用后误报
+inline void poison_on_release(char* data, size_t len) {
+#if defined(AZH_MEMORY_POISON) && defined(AZH_HAS_ASAN)
+    if (data == nullptr || len == 0) return;
+    ASAN_UNPOISON_MEMORY_REGION(data, len);
+#else
+    (void)data;
+    (void)len;
+#endif
+}
+
+#endif // POISON_HPP
@@ -0,0 +1,186 @@
+#include "pool_allocator.hpp"
+#include <algorithm>
+#include <cstdint>
+
+namespace {
+    constexpr size_t HEADER_SIZE = sizeof(void*);
+    constexpr uintptr_t SMALL_TAG = 1;  // 头部最低位为1：指向小对象堆的run；否则是Chunk*
+
+    // 块内布局：[填充][Chunk*][用户数据]，用户数据按alignment对齐
+    char* user_ptr(Chunk* chunk, size_t alignment) {
+        uintptr_t raw = reinterpret_cast<uintptr_t>(chunk->data) + HEADER_SIZE;
+        return reinterpret_cast<char*>((raw + alignment - 1) & ~(uintptr_t{alignment} - 1));
+    }
+
+    constexpr size_t round_up(size_t n, size_t align) { return (n + align - 1) & ~(align - 1); }
+
+    size_t cell_class(size_t bytes) {
+        size_t cls = 0;
+        while ((SmallObjectHeap::MIN_CELL_SIZE << cls) < bytes) ++cls;
+        return cls;
+    }
+
+    size_t cell_size(size_t cls) { return SmallObjectHeap::MIN_CELL_SIZE << cls; }
+}
+
+struct SmallObjectHeap::Run {
+    Chunk* chunk;
+    Run* prev;
+    Run* next;
+    void* free_cells;  // 归还的格子（格子开头存放下一个空闲格子）
+    char* bump;        // 尚未切分区域的起点
+    char* end;
+    size_t cls;
+    size_t used;       // 已分配出去的格子数
+
+    bool full() const { return free_cells == nullptr && bump + cell_size(cls) > end; }
+};
+
+void* SmallObjectHeap::take_cell(ClassList& list, Run* run) {
+    void* cell;
+    if (run->free_cells != nullptr) {
+        cell = run->free_cells;
+        run->free_cells = *static_cast<void**>(cell);
+    } else {
+        cell = run->bump;
+        run->bump += cell_size(run->cls);
+    }
+    ++run->used;
+    if (run->full()) {
+        // 摘出partial链表
+        if (run->prev != nullptr) run->prev->next = run->next; else list.partial = run->next;
+        if (run->next != nullptr) run->next->prev = run->prev;
+        run->prev = run->next = nullptr;
+    }
+    return cell;
+}
+
+void* SmallObjectHeap::allocate(size_t bytes, Run*& run) {
+    size_t cls = cell_class(bytes);
+    ClassList& list = classes_[cls];
+    {
+        std::lock_guard<std::mutex> lock(list.mutex);
+        if (list.partial != nullptr) {
+            run = list.partial;
+            return take_cell(list, run);
+        }
+    }
+
+    // 没有空闲格子：在锁外向内存池申请新run
+    Chunk* chunk = nullptr;
+    try {
+        chunk = pool_.alloc_chunk(std::min(RUN_BYTES, pool_.max_chunk_size()));
+    } catch (const std::exception&) {
+        throw std::bad_alloc();
+    }
+    if (chunk == nullptr) throw std::bad_alloc();
+
+    Run* fresh = ::new (static_cast<void*>(chunk->data)) Run{};
+    fresh->chunk = chunk;
+    fresh->cls = cls;
+    fresh->bump = chunk->data + round_up(sizeof(Run), MIN_CELL_SIZE);
+    fresh->end = chunk->data + chunk->capacity;
+    if (fresh->full()) {
+        pool_.retrieve(chunk);
+        throw std::bad_alloc();  // 内存池最小规格放不下一个格子
+    }
+
+    std::lock_guard<std::mutex> lock(list.mutex);
+    fresh->next = list.partial;
+    if (list.partial != nullptr) list.partial->prev = fresh;
+    list.partial = fresh;
+    run = fresh;
+    return take_cell(list, fresh);
+}
+
+void SmallObjectHeap::deallocate(Run* run, void* cell) noexcept {
+    ClassList& list = classes_[run->cls];
+    Chunk* empty = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(list.mutex);
+        bool was_full = run->full();
+        *static_cast<void**>(cell) = run->free_cells;
+        run->free_cells = cell;
+        if (--run->used == 0) {
+            // 整个run空闲：摘链后归还内存池
+            if (!was_full) {
+                if (run->prev != nullptr) run->prev->next = run->next; else list.partial = run->next;
+                if (run->next != nullptr) run->next->prev = run->prev;
+            }
+            empty = run->chunk;
+        } else if (was_full) {
+            run->prev = nullptr;
+            run->next = list.partial;
+            if (list.partial != nullptr) list.partial->prev = run;
+            list.partial = run;
+        }
+    }
+    if (empty != nullptr) pool_.retrieve(empty);
+}
+
+void* pool_allocate(MemoryPool& pool, size_t bytes, size_t alignment) {
+    alignment = std::max(alignment, alignof(Chunk*));
+    if ((alignment & (alignment - 1)) != 0) throw std::bad_alloc();
+
+    // 小请求：格子布局[头部][用户数据]，格子16字节对齐，用户数据从max(头部, 对齐)处开始
+    if (alignment <= SmallObjectHeap::MIN_CELL_SIZE &&
+        bytes <= SmallObjectHeap::MAX_CELL_SIZE - SmallObjectHeap::MIN_CELL_SIZE) {
+        size_t offset = std::max(HEADER_SIZE, alignment);
+        SmallObjectHeap::Run* run = nullptr;
+        char* cell = static_cast<char*>(pool.small_objects().allocate(offset + bytes, run));
+        char* p = cell + offset;
+        *reinterpret_cast<uintptr_t*>(p - HEADER_SIZE) = reinterpret_cast<uintptr_t>(run) | SMALL_TAG;
+        return p;
+    }
+
+    size_t need = bytes + HEADER_SIZE + alignment - 1;
+    if (need < bytes) throw std::bad_alloc();
+
+    Chunk* chunk = nullptr;
+    if (need > pool.max_chunk_size()) {
+        chunk = new Chunk(need);  // 超出最大规格：单独分配，不经内存池
+    } else {
+        try {
+            chunk = pool.alloc_chunk(need);
+        } catch (const std::exception&) {
+            throw std::bad_alloc();
+        }
+        if (chunk == nullptr) throw std::bad_alloc();
+    }
+
+    char* p = user_ptr(chunk, alignment);
+    *reinterpret_cast<Chunk**>(p - HEADER_SIZE) = chunk;
+    return p;
+}
+
+void pool_deallocate(MemoryPool& pool, void* p) noexcept {
+    if (p == nullptr) return;
+    uintptr_t header = *reinterpret_cast<uintptr_t*>(static_cast<char*>(p) - HEADER_SIZE);
+    if (header & SMALL_TAG) {
+        auto* run = reinterpret_cast<SmallObjectHeap::Run*>(header & ~SMALL_TAG);
+        // 格子起点按16字节对齐，用户数据在格子内的偏移不超过16
+        char* cell = reinterpret_cast<char*>((reinterpret_cast<uintptr_t>(p) - HEADER_SIZE) &
+                                             ~(uintptr_t{SmallObjectHeap::MIN_CELL_SIZE} - 1));
+        pool.small_objects().deallocate(run, cell);
+        return;
+    }
+    Chunk* chunk = reinterpret_cast<Chunk*>(header);
+    if (chunk->capacity > pool.max_chunk_size()) {
+        delete chunk;
+    } else {
+        pool.retrieve(chunk);
+    }
+}
+
+void* PoolMemoryResource::do_allocate(size_t bytes, size_t alignment) {
+    return pool_allocate(*pool_, bytes, alignment);
+}
+
+void PoolMemoryResource::do_deallocate(void* p, size_t, size_t) {
+    pool_deallocate(*pool_, p);
+}
+
+bool PoolMemoryResource::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+    auto* o = dynamic_cast<const PoolMemoryResource*>(&other);
+    return o != nullptr && o->pool_ == pool_;
+}
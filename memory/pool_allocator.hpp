@@ -0,0 +1,110 @@
+#ifndef POOL_ALLOCATOR_HPP
+#define POOL_ALLOCATOR_HPP
+
+#include <array>
+#include <cstddef>
+#include <mutex>
+#include <memory_resource>
+#include <new>
+#include "memory_pool.hpp"
+
+// 小对象堆：把内存池的块（run）切分成同尺寸的格子，按格子规格（16/32/.../512字节）各维护一条有空闲格子的run链表
+// 每个规格一把互斥锁；run中的格子全部归还后整块还给内存池。格子按16字节对齐
+class SmallObjectHeap {
+public:
+    static constexpr size_t MIN_CELL_SIZE = 16;
+    static constexpr size_t MAX_CELL_SIZE = 512;
+    static constexpr size_t CELL_CLASSES = 6;      // 16 << 0 ... 16 << 5
+    static constexpr size_t RUN_BYTES = 4096;      // 每个run向内存池申请的大小
+
+    struct Run;  // run头部，位于块数据区开头（定义见pool_allocator.cpp）
+
+    explicit SmallObjectHeap(MemoryPool& pool) : pool_(pool) {}
+
+    SmallObjectHeap(const SmallObjectHeap&) = delete;
+    SmallObjectHeap& operator=(const SmallObjectHeap&) = delete;
+
+    // 分配一个不小于bytes（<= MAX_CELL_SIZE）的格子，run返回其所属run（释放时传回）
+    // 内存池分配失败时抛出std::bad_alloc
+    void* allocate(size_t bytes, Run*& run);
+    void deallocate(Run* run, void* cell) noexcept;
+
+private:
+    struct ClassList {
+        std::mutex mutex;
+        Run* partial{nullptr};  // 还有空闲格子的run
+    };
+
+    void* take_cell(ClassList& list, Run* run);
+
+    MemoryPool& pool_;
+    std::array<ClassList, CELL_CLASSES> classes_;
+};
+
+// 从内存池分配任意大小、任意对齐的原始内存：
+// 小请求（连同8字节头部不超过SmallObjectHeap::MAX_CELL_SIZE、对齐不超过16）从小对象堆切分格子；
+// 其余取一个不小于所需大小的块，超出最大规格时单独new一个Chunk。所属run/块的指针存放在返回地址之前，释放时据此归还
+// 内存池分配失败时抛出std::bad_alloc（符合标准分配器要求）
+void* pool_allocate(MemoryPool& pool, size_t bytes, size_t alignment = alignof(std::max_align_t));
+// 归还pool_allocate返回的内存（p为nullptr时不做任何事）
+void pool_deallocate(MemoryPool& pool, void* p) noexcept;
+
+// PoolAllocator：满足Allocator要求的STL分配器
+// 小节点（unordered_map/list/map的节点等）从小对象堆按规格切分，多个节点共享一个块；大的数据区（vector/string）各占一个块
+template <class T>
+class PoolAllocator {
+public:
+    using value_type = T;
+
+    // pool为nullptr时使用全局单例内存池
+    PoolAllocator(MemoryPool* pool = nullptr) noexcept
+        : pool_(pool != nullptr ? pool : &MemoryPool::get_instance()) {}
+
+    template <class U>
+    PoolAllocator(const PoolAllocator<U>& other) noexcept : pool_(other.pool()) {}
+
+    T* allocate(size_t n) {
+        if (n > static_cast<size_t>(-1) / sizeof(T)) throw std::bad_array_new_length();
+        return static_cast<T*>(pool_allocate(*pool_, n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T* p, size_t) noexcept {
+        pool_deallocate(*pool_, p);
+    }
+
+    MemoryPool* pool() const noexcept { return pool_; }
+
+private:
+    MemoryPool* pool_;
+};
+
+template <class T, class U>
+bool operator==(const PoolAllocator<T>& a, const PoolAllocator<U>& b) noexcept {
+    return a.pool() == b.pool();
+}
+
+template <class T, class U>
+bool operator!=(const PoolAllocator<T>& a, const PoolAllocator<U>& b) noexcept {
+    return !(a == b);
+}
+
+// PoolMemoryResource：以内存池为后端的std::pmr::memory_resource
+class PoolMemoryResource : public std::pmr::memory_resource {
+public:
+    // pool为nullptr时使用全局单例内存池
+    explicit PoolMemoryResource(MemoryPool* pool = nullptr) noexcept
+        : pool_(pool != nullptr ? pool : &MemoryPool::get_instance()) {}
+
+    MemoryPool* pool() const noexcept { return pool_; }
+
+private:
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+    MemoryPool* pool_;
+};
+
+// 单个请求/连接内临时对象的单调分配区见BumpArena（bump_arena.hpp），它同样是std::pmr::memory_resource
+
+#endif // POOL_ALLOCATOR_HPP
@@ -0,0 +1,96 @@
+#include "shared_block.hpp"
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include "memory_pool.hpp"
+
+namespace {
+
+// 归还数据块：超出最大规格的块单独从堆上申请（不经内存池），直接delete
+void free_block_chunk(MemoryPool& pool, Chunk* chunk) {
+    if (chunk->capacity > pool.max_chunk_size()) {
+        delete chunk;
+    } else {
+        pool.retrieve(chunk);
+    }
+}
+
+}  // namespace
+
+// 创建共享块：从内存池申请数据区（超出最大规格时单独从堆上申请）并拷贝数据
+SharedBlock* SharedBlock::create(const char* data, size_t len) {
+    MemoryPool& pool = MemoryPool::get_instance();
+    size_t need = std::max<size_t>(len, 1);
+    Chunk* chunk = nullptr;
+    try {
+        chunk = need > pool.max_chunk_size() ? new Chunk(need) : pool.alloc_chunk(need);
+    } catch (const std::bad_alloc&) {
+        throw MemoryAllocationError("Failed to allocate shared block of size: " + std::to_string(len));
+    }
+    if (chunk == nullptr) {
+        throw MemoryAllocationError("Failed to allocate shared block of size: " + std::to_string(len));
+    }
+    if (len > 0) {
+        std::memcpy(chunk->data, data, len);
+    }
+    chunk->length = len;
+
+    try {
+        return new SharedBlock(chunk);
+    } catch (...) {
+        free_block_chunk(pool, chunk);
+        throw;
+    }
+}
+
+SharedBlock::~SharedBlock() {
+    free_block_chunk(MemoryPool::get_instance(), chunk_);
+}
+
+void SharedBlock::retain() noexcept {
+    refs_.fetch_add(1, std::memory_order_relaxed);
+}
+
+// acq_rel保证其他线程对共享块的最后一次读取先于释放
+void SharedBlock::release() noexcept {
+    if (refs_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        delete this;
+    }
+}
+
+// SharedBuffer 实现
+SharedBuffer::SharedBuffer(const char* data, size_t len)
+    : block_(SharedBlock::create(data, len)) {
+}
+
+SharedBuffer::~SharedBuffer() {
+    if (block_ != nullptr) block_->release();
+}
+
+SharedBuffer::SharedBuffer(const SharedBuffer& other) noexcept
+    : block_(other.block_) {
+    if (block_ != nullptr) block_->retain();
+}
+
+SharedBuffer& SharedBuffer::operator=(const SharedBuffer& other) noexcept {
+    if (this != &other) {
+        if (other.block_ != nullptr) other.block_->retain();
+        if (block_ != nullptr) block_->release();
+        block_ = other.block_;
+    }
+    return *this;
+}
+
+SharedBuffer::SharedBuffer(SharedBuffer&& other) noexcept
+    : block_(other.block_) {
+    other.block_ = nullptr;
+}
+
+SharedBuffer& SharedBuffer::operator=(SharedBuffer&& other) noexcept {
+    if (this != &other) {
+        if (block_ != nullptr) block_->release();
+        block_ = other.block_;
+        other.block_ = nullptr;
+    }
+    return *this;
+}
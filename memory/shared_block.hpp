@@ -0,0 +1,59 @@
+#ifndef SHARED_BLOCK_HPP
+#define SHARED_BLOCK_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include "chunk.hpp"
+
+// SharedBlock：不可变、带引用计数的共享数据块（数据区来自内存池，超出最大规格时单独从堆上申请）
+// 广播场景下同一份数据只拷贝一次，可按引用挂接到任意多个OutputBuffer链上，
+// 最后一个引用释放时（通常是最后一次writev写完）数据块归还内存池
+class SharedBlock {
+public:
+    // 拷贝len字节创建共享块，初始引用计数为1；内存池分配失败时抛出MemoryAllocationError/MemoryPoolExhaustedError
+    static SharedBlock* create(const char* data, size_t len);
+
+    SharedBlock(const SharedBlock&) = delete;
+    SharedBlock& operator=(const SharedBlock&) = delete;
+
+    void retain() noexcept;
+    // 引用计数减1，归零时数据块归还内存池并销毁自身
+    void release() noexcept;
+
+    const char* data() const { return chunk_->data; }
+    size_t size() const { return chunk_->length; }
+    int use_count() const { return refs_.load(std::memory_order_relaxed); }
+
+private:
+    explicit SharedBlock(Chunk* chunk) : chunk_(chunk) {}
+    ~SharedBlock();
+
+    Chunk* chunk_;
+    std::atomic<int> refs_{1};
+};
+
+// SharedBuffer：SharedBlock的RAII句柄，拷贝只增加引用计数（跨线程传递无需拷贝数据）
+class SharedBuffer {
+public:
+    SharedBuffer() = default;
+    SharedBuffer(const char* data, size_t len);
+    explicit SharedBuffer(std::string_view data) : SharedBuffer(data.data(), data.size()) {}
+    ~SharedBuffer();
+
+    SharedBuffer(const SharedBuffer& other) noexcept;
+    SharedBuffer& operator=(const SharedBuffer& other) noexcept;
+    SharedBuffer(SharedBuffer&& other) noexcept;
+    SharedBuffer& operator=(SharedBuffer&& other) noexcept;
+
+    SharedBlock* block() const { return block_; }
+    const char* data() const { return block_ != nullptr ? block_->data() : nullptr; }
+    size_t size() const { return block_ != nullptr ? block_->size() : 0; }
+    bool empty() const { return size() == 0; }
+
+private:
+    SharedBlock* block_{nullptr};
+};
+
+#endif // SHARED_BLOCK_HPP
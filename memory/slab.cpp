@@ -0,0 +1,171 @@
+#include "slab.hpp"
+#include "poison.hpp"
+#include "numa.hpp"
+#include <sys/mman.h>
+#include <unistd.h>
+#include <new>
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+
+namespace {
+    // 系统默认大页大小（/proc/meminfo中的Hugepagesize），读取失败按2MB
+    size_t huge_page_size() {
+        static const size_t size = [] {
+            size_t kb = 0;
+            if (FILE* f = std::fopen("/proc/meminfo", "r")) {
+                char line[128];
+                while (std::fgets(line, sizeof(line), f) != nullptr) {
+                    if (std::sscanf(line, "Hugepagesize: %zu kB", &kb) == 1) break;
+                }
+                std::fclose(f);
+            }
+            return kb > 0 ? kb * 1024 : size_t{2 * 1024 * 1024};
+        }();
+        return size;
+    }
+
+    size_t round_up(size_t n, size_t align) {
+        return (n + align - 1) / align * align;
+    }
+}
+
+// 创建slab：先映射数据区，再按槽位构造稠密头部数组
+Slab::Slab(size_t chunk_size, size_t chunk_count, int numa_node, HugePageMode huge)
+    : chunk_size_(chunk_size), numa_node_(numa_node), huge_(huge) {
+    assert(chunk_size > 0 && chunk_count > 0);
+    headers_.reserve(chunk_count);  // 一次性预留，之后不再扩容，保证头部地址稳定
+
+    map_region();
+    for (size_t i = 0; i < chunk_count; ++i) {
+        headers_.emplace_back(base_ + i * chunk_size_, chunk_size_);
+    }
+}
+
+Slab::~Slab() {
+    release();
+}
+
+// 映射数据区：按大页策略依次尝试，都不可用时退化为普通匿名映射（按需分配物理页，首次写入时才真正占用内存）
+// 指定了NUMA节点时在首次写入前设置放置策略，之后缺页分配的物理页优先落在该节点
+void Slab::map_region() {
+    size_t len = chunk_size_ * headers_.capacity();
+    huge_backed_ = false;
+    bool mapped = (huge_ == HugePageMode::kExplicit && map_explicit_huge(len)) ||
+                  (huge_ != HugePageMode::kNone && map_transparent_huge(len));
+    if (!mapped) {
+        map_normal(len);
+    }
+    if (numa_node_ >= 0) {
+        bind_to_numa_node(base_, mapped_bytes_, numa_node_);
+    }
+}
+
+// 使用预留大页（/proc/sys/vm/nr_hugepages），未预留或不足时mmap失败
+bool Slab::map_explicit_huge(size_t bytes) {
+#ifdef MAP_HUGETLB
+    size_t len = round_up(bytes, huge_page_size());
+    void* p = ::mmap(nullptr, len, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (p == MAP_FAILED) return false;
+    base_ = static_cast<char*>(p);
+    mapped_bytes_ = len;
+    huge_backed_ = true;
+    return true;
+#else
+    (void)bytes;
+    return false;
+#endif
+}
+
+// 多映射一个大页后裁掉首尾，使数据区按大页边界对齐（否则内核无法用大页承载），再请求透明大页
+// 透明大页被禁用时madvise失败，数据区仍可按普通页使用
+bool Slab::map_transparent_huge(size_t bytes) {
+#ifdef MADV_HUGEPAGE
+    const size_t hp = huge_page_size();
+    size_t len = round_up(bytes, hp);
+    void* p = ::mmap(nullptr, len + hp, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) return false;
+    char* raw = static_cast<char*>(p);
+    char* aligned = reinterpret_cast<char*>(round_up(reinterpret_cast<uintptr_t>(raw), hp));
+    size_t head = static_cast<size_t>(aligned - raw);
+    if (head > 0) ::munmap(raw, head);
+    if (hp - head > 0) ::munmap(aligned + len, hp - head);
+    base_ = aligned;
+    mapped_bytes_ = len;
+    huge_backed_ = ::madvise(aligned, len, MADV_HUGEPAGE) == 0;
+    return true;
+#else
+    (void)bytes;
+    return false;
+#endif
+}
+
+void Slab::map_normal(size_t bytes) {
+    void* p = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) {
+        throw std::bad_alloc();
+    }
+    base_ = static_cast<char*>(p);
+    mapped_bytes_ = bytes;
+}
+
+// 恢复头部初始状态：数据区指回本slab中的对应槽位
+void Slab::reset_header(Chunk* c) {
+    assert(owns(c));
+    if (c->owns_data) {  // 曾被expand_capacity替换为堆内存
+        poison_on_release(c->data, c->capacity);
+        delete[] c->data;
+    }
+    size_t index = static_cast<size_t>(c - headers_.data());
+    c->data = base_ + index * chunk_size_;
+    c->capacity = chunk_size_;
+    c->owns_data = false;
+    c->next = nullptr;
+    c->clear();
+}
+
+// 释放空闲块的物理页（失败时保留物理页，不影响正确性）
+// 块小于一页时不能单独madvise（会波及同页的其他块），只能等整个slab空闲后整体munmap
+// 大页承载时按大页粒度判断：单独释放大页的一部分会把大页拆散，得不偿失
+void Slab::decommit(Chunk* c) {
+    assert(owns(c) && !c->owns_data);
+    static const size_t page_size = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    if (chunk_size_ % (huge_backed_ ? huge_page_size() : page_size) == 0) {
+        ::madvise(c->data, chunk_size_, MADV_DONTNEED);
+    }
+    ++idle_;
+}
+
+void Slab::recommit(Chunk* c) {
+    assert(owns(c) && idle_ > 0);
+    (void)c;
+    --idle_;
+}
+
+// 整体归还数据区（一次munmap）
+void Slab::release() {
+    if (base_ == nullptr) return;
+    poison_on_release(base_, bytes());
+    ::munmap(base_, mapped_bytes_);
+    base_ = nullptr;
+    mapped_bytes_ = 0;
+    huge_backed_ = false;
+    idle_ = 0;
+}
+
+// 重新映射数据区，并让所有头部指向新区域
+void Slab::remap() {
+    if (base_ != nullptr) return;
+    map_region();
+    for (size_t i = 0; i < headers_.size(); ++i) {
+        Chunk& c = headers_[i];
+        c.data = base_ + i * chunk_size_;
+        c.capacity = chunk_size_;
+        c.owns_data = false;
+        c.next = nullptr;
+        c.clear();
+    }
+}
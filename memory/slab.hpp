@@ -0,0 +1,75 @@
+#ifndef SLAB_HPP
+#define SLAB_HPP
+
+#include <cstddef>
+#include <vector>
+#include "chunk.hpp"
+
+// slab数据区的大页策略（不可用时均退化为普通4K页，不影响正确性）
+enum class HugePageMode {
+    kNone,         // 普通页
+    kTransparent,  // 按大页边界对齐映射后madvise(MADV_HUGEPAGE)，由内核透明大页机制合并
+    kExplicit      // 优先mmap(MAP_HUGETLB)使用预留大页，失败时退化为kTransparent
+};
+
+// Slab：一段连续的mmap内存，按固定规格切分为多个内存块的数据区
+// 对应的Chunk头部集中存放在稠密数组中（不单独new），数据区不归Chunk所有（owns_data=false）
+// 头部数组在Slab对象存活期间地址不变，release()只归还数据区，头部可在remap()后复用
+class Slab {
+public:
+    // 创建slab：映射chunk_size * chunk_count字节并初始化头部，映射失败抛出std::bad_alloc
+    // numa_node >= 0 时数据区优先放置在该NUMA节点上；huge指定大页策略
+    Slab(size_t chunk_size, size_t chunk_count, int numa_node = -1, HugePageMode huge = HugePageMode::kNone);
+    ~Slab();
+
+    Slab(const Slab&) = delete;
+    Slab& operator=(const Slab&) = delete;
+
+    size_t chunk_size() const { return chunk_size_; }
+    size_t chunk_count() const { return headers_.size(); }
+    size_t bytes() const { return chunk_size_ * headers_.size(); }
+    bool is_mapped() const { return base_ != nullptr; }
+    // 当前数据区是否由大页承载（MAP_HUGETLB成功，或MADV_HUGEPAGE被内核接受）
+    bool is_huge() const { return huge_backed_; }
+
+    // 第i个内存块的头部
+    Chunk* header(size_t i) { return &headers_[i]; }
+
+    // 判断头部是否属于本slab（按头部数组地址范围判断）
+    bool owns(const Chunk* c) const {
+        return !headers_.empty() && c >= headers_.data() && c < headers_.data() + headers_.size();
+    }
+
+    // 恢复第i个头部的初始状态（数据区指回slab中的对应槽位）
+    void reset_header(Chunk* c);
+
+    // 释放单个空闲块的物理页（madvise(MADV_DONTNEED)，地址保留，再次写入时按需缺页并清零）
+    void decommit(Chunk* c);
+    // 重新启用一个已decommit的块（仅更新计数，物理页在首次写入时分配）
+    void recommit(Chunk* c);
+    // 已decommit的块数
+    size_t idle_count() const { return idle_; }
+
+    // 整体归还数据区给操作系统（一次munmap，O(1)），头部保留
+    void release();
+
+    // 重新映射数据区并让头部指向新区域，失败抛出std::bad_alloc
+    void remap();
+
+private:
+    void map_region();
+    bool map_explicit_huge(size_t bytes);
+    bool map_transparent_huge(size_t bytes);
+    void map_normal(size_t bytes);
+
+    size_t chunk_size_;
+    int numa_node_;
+    HugePageMode huge_;
+    size_t mapped_bytes_{0};      // 实际映射长度（大页模式下向上取整到大页大小）
+    bool huge_backed_{false};
+    char* base_{nullptr};
+    size_t idle_{0};              // 已decommit的块数
+    std::vector<Chunk> headers_;  // 稠密头部数组（reserve后一次性构造，之后不再扩容）
+};
+
+#endif // SLAB_HPP
@@ -6,11 +6,25 @@
 #include <cassert>
 #include <exception>
 #include <cstring>  
+#include <cerrno>
 #include <atomic>   
 #include <cstdlib>   
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+#include <stdexcept>
 
 #include "memory_pool.hpp"
 #include "chunk.hpp"
+#include "poison.hpp"
+#include "numa.hpp"
+#include "data_buf.hpp"
+#include "shared_block.hpp"
+#include "pool_allocator.hpp"
+#include "bump_arena.hpp"
+#include "memory_governor.hpp"
+#include <unistd.h>
+#include <fcntl.h>
 
 using namespace std::chrono;
 
@@ -21,6 +35,15 @@ void print_stats(const PoolStats& s) {
               << "  peak_usage_bytes:     " << s.peak_usage_bytes << "\n"
               << "  current_usage_bytes:  " << s.current_usage_bytes << "\n"
               << "  allocation_failures:  " << s.allocation_failures << "\n";
+    for (const auto& c : s.classes) {
+        if (c.hits + c.misses == 0) continue;
+        std::cout << "  class " << c.size << ": hits=" << c.hits << " misses=" << c.misses
+                  << " requested=" << c.requested_bytes << " served=" << c.served_bytes << "\n";
+    }
+    for (const auto& b : s.request_histogram) {
+        std::cout << "  request <= " << b.max_request << " -> " << b.served_size
+                  << ": count=" << b.count << " bytes=" << b.requested_bytes << "\n";
+    }
 }
 
 // 简单断言工具：如果条件不满足则打印并退出非0
@@ -90,6 +113,925 @@ void each_size_once_test() {
     std::cout << "各规格测试通过\n\n";
 }
 
+void thread_cache_test() {
+    std::cout << "== 线程缓存测试 ==\n";
+    MemoryPool& pool = MemoryPool::get_instance();
+
+    // 同线程归还后再分配，应命中线程缓存（LIFO，拿回同一块）
+    Chunk* a = pool.alloc_chunk(MEM_SIZES[0]);
+    require(a != nullptr, "alloc_chunk returned nullptr");
+    pool.retrieve(a);
+    Chunk* b = pool.alloc_chunk(MEM_SIZES[0]);
+    require(a == b, "thread cache did not reuse the chunk just retrieved");
+    pool.retrieve(b);
+
+    // 子线程在缓存中留下块后退出，统计仍需精确
+    PoolStats before = pool.get_stats();
+    const size_t per_thread = 300;  // 超过缓存上限，触发批量溢出
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&pool, per_thread] {
+            std::vector<Chunk*> held;
+            for (size_t i = 0; i < per_thread; ++i) held.push_back(pool.alloc_chunk(MEM_SIZES[0]));
+            for (Chunk* c : held) pool.retrieve(c);
+        });
+    }
+    for (auto& th : threads) th.join();
+
+    PoolStats after = pool.get_stats();
+    print_stats(after);
+    require(after.total_allocations == before.total_allocations + 4 * per_thread,
+            "total_allocations not exact with thread caches");
+    require(after.total_deallocations == before.total_deallocations + 4 * per_thread,
+            "total_deallocations not exact with thread caches");
+    require(after.current_usage_bytes == before.current_usage_bytes,
+            "current_usage_bytes changed after all chunks were returned");
+    std::cout << "线程缓存测试通过\n\n";
+}
+
+void slab_backing_test() {
+    std::cout << "== slab承载模式测试 ==\n";
+    PoolConfig config;
+    config.backing = ChunkBacking::kSlab;
+    MemoryPool pool(config);
+
+    // 同规格块的数据区来自同一段连续slab
+    std::vector<Chunk*> chunks;
+    for (int i = 0; i < 8; ++i) {
+        Chunk* c = pool.alloc_chunk(MEM_SIZES[0]);
+        require(c != nullptr, "slab alloc_chunk returned nullptr");
+        require(!c->owns_data, "slab chunk should not own its data");
+        std::memset(c->data, i, c->capacity);
+        chunks.push_back(c);
+    }
+    auto lo = std::min_element(chunks.begin(), chunks.end(),
+                               [](Chunk* a, Chunk* b) { return a->data < b->data; });
+    auto hi = std::max_element(chunks.begin(), chunks.end(),
+                               [](Chunk* a, Chunk* b) { return a->data < b->data; });
+    require(static_cast<size_t>((*hi)->data - (*lo)->data) < config.slab_bytes,
+            "slab chunks are not carved from one contiguous region");
+
+    // 扩容过的slab块归还后应恢复原槽位
+    Chunk* grown = chunks.back();
+    require(grown->expand_capacity(grown->capacity * 2), "expand_capacity failed");
+    pool.retrieve(grown);
+    chunks.pop_back();
+
+    // 所有规格都可分配
+    for (size_t s : MEM_SIZES) {
+        Chunk* c = pool.alloc_chunk(s);
+        require(c != nullptr && c->capacity == s, "slab alloc_chunk failed for supported size");
+        chunks.push_back(c);
+    }
+    for (Chunk* c : chunks) pool.retrieve(c);
+    require(pool.get_stats().current_usage_bytes == 0, "slab pool usage not zero after returns");
+
+    // 清空后仍可继续分配（已归还的slab按需重新映射）
+    pool.clear();
+    Chunk* again = pool.alloc_chunk(MEM_SIZES[1]);
+    require(again != nullptr && again->capacity == MEM_SIZES[1], "alloc after clear failed");
+    pool.retrieve(again);
+
+    // 细粒度小规格：一个slab的块数远超默认高水位，新slab入链后不应立即被裁剪
+    PoolConfig fine;
+    fine.backing = ChunkBacking::kSlab;
+    fine.classes = PoolConfig::fine_grained_classes();
+    MemoryPool fine_pool(fine);
+    const size_t per_slab = fine.slab_bytes / 512;
+    require(fine_pool.get_free_chunks(512) == per_slab, "fresh small-class slab trimmed on arrival");
+    std::cout << "slab承载模式测试通过\n\n";
+}
+
+// 大页承载：大规格改由slab承载（堆模式下也是），大页不可用时退化为普通页，读写与归还不受影响
+void huge_page_test(HugePageMode mode) {
+    std::cout << "== 大页承载测试（" << (mode == HugePageMode::kExplicit ? "explicit" : "transparent") << "） ==\n";
+    PoolConfig config;
+    config.huge_pages = mode;
+    MemoryPool pool(config);
+
+    std::vector<Chunk*> chunks;
+    for (size_t s : MEM_SIZES) {
+        Chunk* c = pool.alloc_chunk(s);
+        require(c != nullptr && c->capacity == s, "huge pool alloc_chunk failed");
+        bool large = s >= config.huge_page_min_size;
+        require(c->owns_data != large, "large classes should be slab backed, small ones heap backed");
+        std::memset(c->data, static_cast<int>(s >> 12), c->capacity);
+        chunks.push_back(c);
+    }
+    size_t huge_bytes = pool.get_huge_page_bytes();
+    std::cout << "huge page bytes: " << huge_bytes << "\n";
+    if (huge_bytes > 0) {
+        // 大页承载的slab按大页边界对齐，4M块的数据区也应对齐
+        require(reinterpret_cast<uintptr_t>(chunks.back()->data) % (2 * 1024 * 1024) == 0,
+                "huge page slab not aligned");
+    }
+    for (Chunk* c : chunks) {
+        require(static_cast<unsigned char>(c->data[c->capacity - 1]) == ((c->capacity >> 12) & 0xff),
+                "huge pool chunk content mismatch");
+        pool.retrieve(c);
+    }
+    require(pool.get_current_usage() == 0, "huge pool usage not zero after returns");
+
+    pool.trim(true);
+    pool.clear();
+    require(pool.get_huge_page_bytes() == 0, "huge page slabs not released after clear");
+    Chunk* again = pool.alloc_chunk(MEM_SIZES[5]);
+    require(again != nullptr && again->capacity == MEM_SIZES[5], "huge pool alloc after clear failed");
+    pool.retrieve(again);
+    std::cout << "大页承载测试通过\n\n";
+}
+
+// 分片统计：命中/未命中、请求大小直方图与多线程合并
+void pool_stats_test() {
+    std::cout << "== 分片统计测试 ==\n";
+    PoolConfig config;
+    config.classes = {{4096, 2, 2, 64}, {65536, 0, 0, 8}};
+    MemoryPool pool(config);
+
+    std::vector<Chunk*> chunks;
+    for (int i = 0; i < 3; ++i) chunks.push_back(pool.alloc_chunk(3000));
+    require(pool.alloc_chunk(1 << 20) == nullptr, "oversize request should fail");
+    PoolStats s = pool.get_stats();
+    require(s.classes.size() == 2 && s.classes[0].size == 4096, "class stats missing");
+    require(s.classes[0].hits == 2 && s.classes[0].misses == 1, "hit/miss count mismatch");
+    require(s.classes[0].requested_bytes == 9000 && s.classes[0].served_bytes == 3 * 4096,
+            "fragmentation stats mismatch");
+    require(s.allocation_failures == 1 && s.total_allocations == 3, "totals mismatch");
+    require(s.request_histogram.size() == 2, "histogram bucket count mismatch");
+    require(s.request_histogram[0].max_request == 4096 && s.request_histogram[0].served_size == 4096 &&
+            s.request_histogram[0].count == 3, "histogram bucket mismatch");
+    require(s.request_histogram[1].max_request == (1 << 20) && s.request_histogram[1].served_size == 0,
+            "oversize bucket mismatch");
+    for (Chunk* c : chunks) pool.retrieve(c);
+
+    // 多线程写入各自分片，读取时合并后总数精确
+    const int threads = 8, ops = 2000;
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&pool, t] {
+            for (int i = 0; i < ops; ++i) {
+                Chunk* c = pool.alloc_chunk(t % 2 == 0 ? 100 : 40000);
+                require(c != nullptr, "stats stress alloc failed");
+                pool.retrieve(c);
+            }
+        });
+    }
+    for (auto& w : workers) w.join();
+    s = pool.get_stats();
+    print_stats(s);
+    require(s.total_allocations == 3 + threads * ops, "merged allocation count mismatch");
+    require(s.total_deallocations == 3 + threads * ops, "merged deallocation count mismatch");
+    require(s.classes[0].hits + s.classes[0].misses + s.classes[1].hits + s.classes[1].misses ==
+            s.total_allocations, "per-class counts do not add up");
+
+    pool.clear();
+    s = pool.get_stats();
+    require(s.total_allocations == 0 && s.request_histogram.empty(), "stats not reset by clear");
+    std::cout << "分片统计测试通过\n\n";
+}
+
+// STL分配器适配：PoolAllocator小节点从小对象堆切分、大数据区直接取块；pmr容器经BumpArena按请求一次性归还
+void pool_allocator_test() {
+    std::cout << "== STL分配器适配测试 ==\n";
+    PoolConfig config;
+    config.classes = {{256, 0, 0, 64}, {4096, 0, 0, 64}, {65536, 0, 0, 8}};
+    MemoryPool pool(config);
+
+    {
+        std::vector<int, PoolAllocator<int>> v{PoolAllocator<int>(&pool)};
+        for (int i = 0; i < 8000; ++i) v.push_back(i);
+        require(pool.get_current_usage() > 0, "PoolAllocator did not use the pool");
+        for (int i = 0; i < 8000; ++i) require(v[i] == i, "PoolAllocator vector content mismatch");
+
+        using Str = std::basic_string<char, std::char_traits<char>, PoolAllocator<char>>;
+        Str str{PoolAllocator<char>(&pool)};
+        str.assign(1000, 'x');
+        require(str.size() == 1000 && str.back() == 'x', "PoolAllocator string mismatch");
+        require(PoolAllocator<char>(&pool) == PoolAllocator<int>(&pool), "allocator equality mismatch");
+
+        // 超对齐请求
+        void* p = pool_allocate(pool, 100, 256);
+        require(reinterpret_cast<uintptr_t>(p) % 256 == 0, "over-aligned allocation misaligned");
+        pool_deallocate(pool, p);
+
+        // 超出最大规格的请求单独分配，不计入内存池
+        size_t usage = pool.get_current_usage();
+        char* big = static_cast<char*>(pool_allocate(pool, 200000));
+        std::memset(big, 1, 200000);
+        require(pool.get_current_usage() == usage, "oversize allocation should bypass the pool");
+        pool_deallocate(pool, big);
+    }
+    require(pool.get_current_usage() == 0, "PoolAllocator leaked chunks");
+
+    {
+        // 小节点从小对象堆切分：多个节点共享一个块，而不是每个节点占一个块
+        using Node = std::pair<const int, int>;
+        std::unordered_map<int, int, std::hash<int>, std::equal_to<int>, PoolAllocator<Node>>
+            map(0, std::hash<int>(), std::equal_to<int>(), PoolAllocator<Node>(&pool));
+        const int count = 20000;
+        for (int i = 0; i < count; ++i) map.emplace(i, i * 2);
+        for (int i = 0; i < count; i += 97) require(map.at(i) == i * 2, "PoolAllocator map content mismatch");
+        require(pool.get_current_usage() < static_cast<size_t>(count) * 64 + 512 * 1024,
+                "small nodes should share pool chunks");
+        for (int i = 0; i < count; i += 2) map.erase(i);
+        for (int i = 0; i < count; i += 2) map.emplace(i, -i);
+        require(map.size() == static_cast<size_t>(count) && map.at(4) == -4, "PoolAllocator map reuse mismatch");
+
+        // 多线程分配、另一线程释放
+        std::vector<std::vector<void*>> per_thread(4);
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < per_thread.size(); ++t) {
+            threads.emplace_back([&pool, &per_thread, t] {
+                for (int i = 0; i < 5000; ++i) {
+                    size_t n = 1 + static_cast<size_t>(i) % 300;
+                    void* p = pool_allocate(pool, n, i % 3 == 0 ? 16 : 8);
+                    std::memset(p, static_cast<int>(t), n);
+                    per_thread[t].push_back(p);
+                }
+            });
+        }
+        for (auto& th : threads) th.join();
+        for (auto& ptrs : per_thread) {
+            for (void* p : ptrs) pool_deallocate(pool, p);
+        }
+    }
+    require(pool.get_current_usage() == 0, "small object heap leaked runs");
+
+    {
+        BumpArena arena(&pool, 4096, 0);
+        std::pmr::memory_resource* mr = arena.resource();
+        for (int round = 0; round < 3; ++round) {
+            {
+                std::pmr::unordered_map<std::pmr::string, std::pmr::string> headers(mr);
+                std::pmr::vector<std::pmr::string> lines(mr);
+                for (int i = 0; i < 200; ++i) {
+                    std::string key = "X-Header-" + std::to_string(i);
+                    headers.emplace(std::pmr::string(key, mr), std::pmr::string(300, 'v', mr));
+                    lines.emplace_back("line " + std::to_string(i));
+                }
+                require(headers.size() == 200 && headers.at(std::pmr::string("X-Header-7", mr)).size() == 300,
+                        "pmr unordered_map content mismatch");
+                require(lines.back() == "line 199", "pmr vector content mismatch");
+            }
+            require(pool.get_current_usage() > 0, "arena buffers should stay until reset");
+            arena.reset();
+            require(pool.get_current_usage() == arena.retained_bytes(), "arena kept blocks beyond max_retained");
+            arena.release();
+            require(pool.get_current_usage() == 0, "arena release did not return buffers");
+        }
+        PoolMemoryResource a(&pool), b(&pool), c;
+        require(a.is_equal(b) && !a.is_equal(c), "memory resource equality mismatch");
+    }
+    std::cout << "STL分配器适配测试通过\n\n";
+}
+
+// 请求分配区：指针递增分配，reset后复用同一批块，超大分配与超出保留上限的块归还内存池
+void bump_arena_test() {
+    std::cout << "== 请求分配区测试 ==\n";
+    PoolConfig config;
+    config.classes = {{4096, 0, 0, 64}, {65536, 0, 0, 8}};
+    MemoryPool pool(config);
+    {
+        BumpArena arena(&pool, 4096, 8192);
+        for (int round = 0; round < 3; ++round) {
+            char* first = static_cast<char*>(arena.alloc(10, 1));
+            auto* n64 = static_cast<uint64_t*>(arena.alloc(sizeof(uint64_t), alignof(uint64_t)));
+            require(reinterpret_cast<uintptr_t>(n64) % alignof(uint64_t) == 0, "arena alignment mismatch");
+            *n64 = 42;
+            std::memset(first, 'a', 10);
+            for (int i = 0; i < 100; ++i) arena.alloc(100);  // 跨越多个块
+            {
+                std::pmr::vector<std::pmr::string> parts(&arena);
+                for (int i = 0; i < 20; ++i) parts.emplace_back(std::string(50, 'p'));
+                require(parts.size() == 20 && parts[19].size() == 50, "pmr over arena mismatch");
+            }
+            void* big = arena.alloc(200000);  // 超过最大规格
+            std::memset(big, 0, 200000);
+            require(arena.used_bytes() > 200000, "used bytes mismatch");
+            require(*n64 == 42, "arena data overwritten");
+
+            size_t usage = pool.get_current_usage();
+            arena.reset();
+            require(arena.used_bytes() == 0, "reset did not clear usage");
+            require(arena.retained_bytes() <= 8192, "arena kept more than max_retained");
+            require(pool.get_current_usage() < usage, "reset did not return extra chunks");
+            // reset后从第一个块重新开始
+            require(static_cast<char*>(arena.alloc(10, 1)) == first, "arena did not reuse first chunk");
+            arena.reset();
+        }
+        require(pool.get_current_usage() == arena.retained_bytes(), "arena usage accounting mismatch");
+    }
+    require(pool.get_current_usage() == 0, "arena leaked chunks");
+    std::cout << "请求分配区测试通过\n\n";
+}
+
+// 可配置规格表：细粒度规格的O(1)查找、预分配数量、非法配置与单例配置时机
+void size_class_config_test() {
+    std::cout << "== 规格表配置测试 ==\n";
+    PoolConfig config;
+    config.classes = PoolConfig::fine_grained_classes();
+    for (ChunkBacking backing : {ChunkBacking::kHeap, ChunkBacking::kSlab}) {
+        config.backing = backing;
+        MemoryPool pool(config);
+        require(pool.class_count() == config.classes.size(), "class_count mismatch");
+        require(pool.max_chunk_size() == MEM_SIZES.back(), "max_chunk_size mismatch");
+
+        const size_t cases[][2] = {
+            {1, 512}, {512, 512}, {513, 1024}, {1500, 2048}, {2048, 2048}, {3000, 4096},
+            {5000, 8192}, {8193, 16384}, {20000, 65536}, {MEM_SIZES.back(), MEM_SIZES.back()},
+        };
+        for (const auto& c : cases) {
+            Chunk* chunk = pool.alloc_chunk(c[0]);
+            require(chunk != nullptr && chunk->capacity == c[1], "fine-grained class lookup mismatch");
+            std::memset(chunk->data, 0x11, chunk->capacity);
+            pool.retrieve(chunk);
+        }
+        require(pool.alloc_chunk(MEM_SIZES.back() + 1) == nullptr, "oversized request should fail");
+        require(pool.get_free_chunks(8192) >= config.classes[4].warm_up, "warm-up count not applied");
+        require(pool.get_stats().current_usage_bytes == 0, "usage not zero after size class test");
+    }
+
+    // 非法规格表
+    auto rejects = [](std::vector<SizeClassSpec> classes) {
+        PoolConfig bad;
+        bad.classes = std::move(classes);
+        try {
+            MemoryPool::validate(bad);
+        } catch (const std::invalid_argument&) {
+            return true;
+        }
+        return false;
+    };
+    require(rejects({}), "empty class table accepted");
+    require(rejects({{3000, 0, 0, 0}}), "non power-of-two class accepted");
+    require(rejects({{4096, 0, 0, 0}, {1024, 0, 0, 0}}), "unsorted class table accepted");
+    require(rejects({{32, 0, 0, 0}}), "too small class accepted");
+
+    // 单例已创建（前面的测试已使用）后不能再配置
+    bool threw = false;
+    try {
+        MemoryPool::configure(config);
+    } catch (const std::logic_error&) {
+        threw = true;
+    }
+    require(threw, "configure after first use should throw");
+    std::cout << "规格表配置测试通过\n\n";
+}
+
+// 水位与trim：超过高水位立即裁剪，trim按空闲窗口/强制释放到低水位，释放后仍可正常分配
+void trim_test(ChunkBacking backing) {
+    std::cout << "== 水位与trim测试（" << (backing == ChunkBacking::kSlab ? "kSlab" : "kHeap") << "） ==\n";
+    const size_t big = MEM_SIZES[4];  // 1M规格：不经过线程缓存，便于精确观察全局空闲块数
+    PoolConfig config;
+    config.backing = backing;
+    config.classes[4].low_watermark = 1;
+    config.classes[4].high_watermark = 3;
+    config.trim_idle_ms = 60 * 1000;
+    MemoryPool pool(config);
+    require(pool.get_free_chunks(big) == 3, "preallocation above high watermark not trimmed");
+
+    std::vector<Chunk*> chunks;
+    for (int i = 0; i < 6; ++i) chunks.push_back(pool.alloc_chunk(big));
+    for (Chunk* c : chunks) pool.retrieve(c);
+    chunks.clear();
+    require(pool.get_free_chunks(big) == 3, "free chunks above high watermark after retrieve");
+
+    // 空闲窗口未到：非强制trim不释放
+    require(pool.trim() == 0, "trim released memory inside idle window");
+
+    // 强制trim：释放到低水位
+    size_t released = pool.trim(true);
+    require(pool.get_free_chunks(big) == 1, "forced trim did not stop at low watermark");
+    require(released >= 2 * big, "forced trim released too little");
+
+    // 释放后仍可分配并正常读写
+    for (int i = 0; i < 4; ++i) {
+        Chunk* c = pool.alloc_chunk(big);
+        require(c != nullptr && c->capacity == big, "alloc after trim failed");
+        std::memset(c->data, 0x5A, c->capacity);
+        chunks.push_back(c);
+    }
+    for (Chunk* c : chunks) pool.retrieve(c);
+    require(pool.get_stats().current_usage_bytes == 0, "usage not zero after trim test");
+
+    // 空闲窗口到期：只释放窗口内从未被取用过的块（空闲数最低时为1，因此只释放1个）
+    config.trim_idle_ms = 0;
+    MemoryPool windowed(config);
+    Chunk* a = windowed.alloc_chunk(big);
+    Chunk* b = windowed.alloc_chunk(big);
+    windowed.retrieve(a);
+    windowed.retrieve(b);
+    require(windowed.get_free_chunks(big) == 3, "unexpected free chunks before windowed trim");
+    require(windowed.trim() >= big, "windowed trim released nothing");
+    require(windowed.get_free_chunks(big) == 2, "windowed trim released recently used chunks");
+    std::cout << "水位与trim测试通过\n\n";
+}
+
+#ifdef AZH_MEMORY_POISON
+// 毒化模式：分配出的数据区为0xCD，expand_capacity新增部分同样为0xCD
+void poison_test() {
+    std::cout << "== 内存毒化测试 ==\n";
+    MemoryPool pool{PoolConfig()};
+    Chunk* c = pool.alloc_chunk(MEM_SIZES[0]);
+    require(c != nullptr, "alloc_chunk returned nullptr");
+    for (size_t i = 0; i < c->capacity; ++i) {
+        require(static_cast<unsigned char>(c->data[i]) == POISON_ALLOC_BYTE,
+                "allocated chunk data not filled with alloc pattern");
+    }
+    std::memset(c->data, 'x', 16);
+    c->length = 16;
+    require(c->expand_capacity(c->capacity * 2), "expand_capacity failed");
+    require(c->data[15] == 'x', "expand_capacity lost existing data");
+    require(static_cast<unsigned char>(c->data[16]) == POISON_ALLOC_BYTE,
+            "expanded region not filled with alloc pattern");
+    pool.retrieve(c);
+    std::cout << "内存毒化测试通过\n\n";
+}
+#endif
+
+// 链式缓冲区：大数据分段追加、writev写出、readv读入，内容与长度保持一致且无1MB上限
+void buffer_chain_test(ReadMode mode) {
+    std::cout << "== 链式缓冲区测试（" << (mode == ReadMode::kExtraBuf ? "kExtraBuf" : "kSpareChunk") << "） ==\n";
+    int fds[2];
+    require(::pipe(fds) == 0, "pipe failed");
+    ::fcntl(fds[0], F_SETFL, O_NONBLOCK);
+    ::fcntl(fds[1], F_SETFL, O_NONBLOCK);
+
+    const size_t total = 3 * 1024 * 1024 + 123;
+    std::vector<char> expected(total);
+    for (size_t i = 0; i < total; ++i) expected[i] = static_cast<char>((i * 131) & 0xFF);
+
+    OutputBuffer out;
+    size_t offset = 0;
+    size_t piece = 1;
+    while (offset < total) {
+        size_t n = std::min(piece, total - offset);
+        require(out.write_to_buf(expected.data() + offset, static_cast<int>(n)) == 0,
+                "write_to_buf failed");
+        offset += n;
+        piece = piece * 3 + 7;
+    }
+    require(static_cast<size_t>(out.length()) == total, "output buffer length mismatch");
+
+    InputBuffer in;
+    in.set_read_mode(mode);
+    while (out.length() > 0) {
+        require(out.write_to_fd(fds[1]) >= 0, "write_to_fd failed");
+        while (in.read_from_fd(fds[0]) > 0) {
+        }
+    }
+    require(static_cast<size_t>(in.length()) == total, "input buffer length mismatch");
+
+    // 先部分消费跨块数据，再取连续视图校验剩余内容
+    const size_t consumed = 70000;
+    in.pop(static_cast<int>(consumed));
+    const char* view = in.get_from_buf();
+    require(view != nullptr, "get_from_buf returned nullptr");
+    require(std::memcmp(view, expected.data() + consumed, total - consumed) == 0,
+            "buffer content mismatch");
+    in.clear();
+    require(in.length() == 0 && in.get_from_buf() == nullptr, "clear did not empty buffer");
+
+    ::close(fds[0]);
+    ::close(fds[1]);
+    std::cout << "链式缓冲区测试通过\n\n";
+}
+
+// 超出内存池最大规格的合并：合并块不经内存池，反复合并后内存池用量应回到0
+void oversize_linearize_test() {
+    std::cout << "== 超大合并测试 ==\n";
+    PoolConfig config;
+    config.classes = {{4 * 1024, 0, 0, 64}, {64 * 1024, 0, 0, 16}};
+    MemoryPool pool(config);
+
+    int fds[2];
+    require(::pipe(fds) == 0, "pipe failed");
+    ::fcntl(fds[0], F_SETFL, O_NONBLOCK);
+    ::fcntl(fds[1], F_SETFL, O_NONBLOCK);
+
+    const size_t total = 200000;
+    std::string expected(total, '\0');
+    for (size_t i = 0; i < total; ++i) expected[i] = static_cast<char>('a' + i % 26);
+
+    for (int round = 0; round < 3; ++round) {
+        {
+            OutputBuffer out(&pool);
+            InputBuffer in(&pool);
+            require(out.write_to_buf(expected.data(), static_cast<int>(total)) == 0, "write_to_buf failed");
+            while (out.length() > 0) {
+                require(out.write_to_fd(fds[1]) >= 0, "write_to_fd failed");
+                while (in.read_from_fd(fds[0]) > 0) {
+                }
+            }
+            require(static_cast<size_t>(in.length()) == total, "input buffer length mismatch");
+            std::string_view all = in.peek();
+            require(all.size() == total && all == expected, "oversize linearize content mismatch");
+        }
+        require(pool.get_current_usage() == 0, "oversize linearize leaked pool usage");
+    }
+
+    ::close(fds[0]);
+    ::close(fds[1]);
+    std::cout << "超大合并测试通过\n\n";
+}
+
+// 规格表的最大规格小于MAX_CHAIN_CHUNK_SIZE：挂接块按最大规格申请，大块写入与读取不应失败
+void small_max_class_buffer_test() {
+    std::cout << "== 小最大规格缓冲区测试 ==\n";
+    PoolConfig config;
+    config.classes = {{4 * 1024, 0, 0, 64}, {16 * 1024, 0, 0, 16}};
+    MemoryPool pool(config);
+
+    std::string payload(20000, '\0');
+    for (size_t i = 0; i < payload.size(); ++i) payload[i] = static_cast<char>('a' + i % 26);
+
+    for (ReadMode mode : {ReadMode::kExtraBuf, ReadMode::kSpareChunk}) {
+        int fds[2];
+        require(::pipe(fds) == 0, "pipe failed");
+        ::fcntl(fds[0], F_SETFL, O_NONBLOCK);
+        ::fcntl(fds[1], F_SETFL, O_NONBLOCK);
+        {
+            OutputBuffer out(&pool);
+            InputBuffer in(&pool);
+            in.set_read_mode(mode);
+            require(out.write_to_buf(payload.data(), static_cast<int>(payload.size())) == 0,
+                    "write_to_buf larger than the biggest class failed");
+            while (out.length() > 0) {
+                require(out.write_to_fd(fds[1]) >= 0, "write_to_fd failed");
+                int n;
+                while ((n = in.read_from_fd(fds[0])) > 0) {
+                }
+                require(n == -1 && errno == EAGAIN, "read_from_fd failed");
+            }
+            require(in.peek() == payload, "content mismatch");
+        }
+        require(pool.get_current_usage() == 0, "pool usage not zero after buffers destroyed");
+        ::close(fds[0]);
+        ::close(fds[1]);
+    }
+    std::cout << "小最大规格缓冲区测试通过\n\n";
+}
+
+// kExtraBuf模式：无数据可读时不占用内存块，小请求只占用一个最小块
+void extrabuf_small_read_test() {
+    std::cout << "== 临时缓冲区读取测试 ==\n";
+    int fds[2];
+    require(::pipe(fds) == 0, "pipe failed");
+    ::fcntl(fds[0], F_SETFL, O_NONBLOCK);
+
+    MemoryPool& pool = MemoryPool::get_instance();
+    size_t usage_before = pool.get_current_usage();
+
+    InputBuffer in;
+    require(in.read_from_fd(fds[0]) == -1 && errno == EAGAIN, "read on empty pipe should fail with EAGAIN");
+    require(pool.get_current_usage() == usage_before, "empty read allocated pool memory");
+
+    const char request[] = "GET / HTTP/1.1\r\nHost: a\r\n\r\n";
+    require(::write(fds[1], request, sizeof(request) - 1) == static_cast<ssize_t>(sizeof(request) - 1),
+            "pipe write failed");
+    require(in.read_from_fd(fds[0]) == static_cast<int>(sizeof(request) - 1), "short read");
+    require(pool.get_current_usage() == usage_before + MEM_SIZES[0],
+            "small read should hold exactly one smallest chunk");
+    require(std::memcmp(in.get_from_buf(), request, sizeof(request) - 1) == 0, "content mismatch");
+
+    ::close(fds[1]);
+    require(in.read_from_fd(fds[0]) == 0, "read after writer closed should report EOF");
+    ::close(fds[0]);
+    std::cout << "临时缓冲区读取测试通过\n\n";
+}
+
+// 缓冲区内存不足：两种读取模式都应返回-1且errno为ENOMEM，不能被误认为EAGAIN
+void read_alloc_failure_test() {
+    std::cout << "== 读取内存不足测试 ==\n";
+    PoolConfig config;
+    for (SizeClassSpec& spec : config.classes) spec.warm_up = 0;
+    MemoryPool pool(config);
+    pool.set_max_capacity(0);
+
+    for (ReadMode mode : {ReadMode::kExtraBuf, ReadMode::kSpareChunk}) {
+        int fds[2];
+        require(::pipe(fds) == 0, "pipe failed");
+        ::fcntl(fds[0], F_SETFL, O_NONBLOCK);
+        require(::write(fds[1], "ping", 4) == 4, "pipe write failed");
+
+        InputBuffer in(&pool);
+        in.set_read_mode(mode);
+        errno = EAGAIN;
+        require(in.read_from_fd(fds[0]) == -1, "read without buffer memory should fail");
+        require(errno == ENOMEM, "allocation failure should report ENOMEM");
+        require(in.length() == 0, "failed read left data in buffer");
+
+        ::close(fds[0]);
+        ::close(fds[1]);
+    }
+    std::cout << "读取内存不足测试通过\n\n";
+}
+
+// 摊还压缩：部分消费后的稳态读取不搬移数据，只有链尾空间不足且搬移量不超过已消费前缀时才压缩
+void buffer_compaction_test() {
+    std::cout << "== 缓冲区压缩策略测试 ==\n";
+    int fds[2];
+    require(::pipe(fds) == 0, "pipe failed");
+    ::fcntl(fds[0], F_SETFL, O_NONBLOCK);
+
+    PoolConfig config;
+    config.classes = {{4096, 0, 0, 8}};
+    MemoryPool pool(config);
+    {
+        InputBuffer in(&pool);
+        std::string data(4096, 'd');
+        for (size_t i = 0; i < data.size(); ++i) data[i] = static_cast<char>('a' + i % 26);
+
+        require(::write(fds[1], data.data(), 3000) == 3000, "pipe write failed");
+        require(in.read_from_fd(fds[0]) == 3000, "short read");
+        in.pop(100);
+        const char* start = in.peek(1).data() - 100;  // 块首
+
+        // 流水线请求：前缀已消费但剩余数据多，读入不搬移
+        const char* before = in.peek(1).data();
+        require(::write(fds[1], data.data() + 3000, 500) == 500, "pipe write failed");
+        require(in.read_from_fd(fds[0]) == 500, "short read");
+        require(in.peek(1).data() == before, "steady-state read moved data");
+        require(in.length() == 3400, "length mismatch after read");
+
+        // 大部分已消费、链尾空间不足：压缩后复用原块而不是挂接新块
+        in.pop(3000);
+        size_t usage = pool.get_current_usage();
+        require(::write(fds[1], data.data() + 3500, 300) == 300, "pipe write failed");
+        require(in.read_from_fd(fds[0]) == 300, "short read");
+        std::string_view view = in.peek(700);
+        require(view.data() == start, "tail was not compacted");
+        require(pool.get_current_usage() == usage, "compaction should not allocate");
+        require(view == std::string_view(data.data() + 3100, 700), "content mismatch after compaction");
+    }
+    require(pool.get_current_usage() == 0, "buffer leaked chunks");
+
+    ::close(fds[0]);
+    ::close(fds[1]);
+    std::cout << "缓冲区压缩策略测试通过\n\n";
+}
+
+// 零拷贝读取接口：跨块查找、前缀视图、网络字节序整数
+void buffer_peek_find_test() {
+    std::cout << "== 零拷贝读取接口测试 ==\n";
+    int fds[2];
+    require(::pipe(fds) == 0, "pipe failed");
+    ::fcntl(fds[0], F_SETFL, O_NONBLOCK);
+
+    // 第一次读入4095字节（首块剩1字节），第二次读入的"\r\n\r\n"跨越块边界
+    std::string head(4095, 'a');
+    std::string rest = "\r\n\r\nbody";
+    InputBuffer in;
+    require(::write(fds[1], head.data(), head.size()) == static_cast<ssize_t>(head.size()), "pipe write failed");
+    require(in.read_from_fd(fds[0]) == static_cast<int>(head.size()), "first read failed");
+    require(::write(fds[1], rest.data(), rest.size()) == static_cast<ssize_t>(rest.size()), "pipe write failed");
+    require(in.read_from_fd(fds[0]) == static_cast<int>(rest.size()), "second read failed");
+
+    require(in.find_crlf() == 4095, "find_crlf across chunks failed");
+    require(in.find("\r\n\r\n") == 4095, "find across chunks failed");
+    require(in.find_crlf(4096) == 4097, "find_crlf with offset failed");
+    require(in.find("body") == 4099, "find in second chunk failed");
+    require(in.find("nothing") == InputBuffer::npos, "find should miss");
+    require(in.peek(4).size() == 4 && in.peek(4) == "aaaa", "peek prefix failed");
+
+    std::string_view all = in.peek();
+    require(all.size() == head.size() + rest.size(), "peek size mismatch");
+    require(all.substr(4095) == rest, "peek content mismatch");
+    in.pop(static_cast<int>(in.find("\r\n\r\n") + 4));
+    require(in.peek() == "body", "pop after find failed");
+    in.clear();
+
+    const unsigned char be[] = {0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08};
+    require(::write(fds[1], be, sizeof(be)) == static_cast<ssize_t>(sizeof(be)), "pipe write failed");
+    require(in.read_from_fd(fds[0]) == static_cast<int>(sizeof(be)), "int read failed");
+    require(in.peek_uint8() == 0x01, "peek_uint8 failed");
+    require(in.peek_uint16() == 0x0102, "peek_uint16 failed");
+    require(in.peek_uint32() == 0x01020304u, "peek_uint32 failed");
+    require(in.peek_uint64() == 0x0102030405060708ull, "peek_uint64 failed");
+    in.pop(7);
+    bool threw = false;
+    try {
+        in.peek_uint16();
+    } catch (const std::out_of_range&) {
+        threw = true;
+    }
+    require(threw, "peek_uint16 should throw on short buffer");
+
+    ::close(fds[0]);
+    ::close(fds[1]);
+    std::cout << "零拷贝读取接口测试通过\n\n";
+}
+
+// 共享数据块：挂接到多个OutputBuffer只增加引用计数，全部写出后数据块归还内存池
+void shared_block_test() {
+    std::cout << "== 共享数据块测试 ==\n";
+    MemoryPool& pool = MemoryPool::get_instance();
+    size_t usage_before = pool.get_current_usage();
+
+    std::string payload(100000, 'p');
+    for (size_t i = 0; i < payload.size(); ++i) payload[i] = static_cast<char>('a' + i % 26);
+
+    const int outputs = 8;
+    {
+        SharedBuffer shared(payload);
+        std::vector<OutputBuffer> bufs(outputs);
+        for (auto& b : bufs) {
+            require(b.write_to_buf("hdr:", 4) == 0, "write header failed");
+            require(b.write_to_buf(shared) == 0, "write shared failed");
+            require(b.write_to_buf("\n", 1) == 0, "write trailer failed");
+        }
+        require(shared.block()->use_count() == outputs + 1, "shared block refcount mismatch");
+        size_t usage_shared = pool.get_current_usage();
+        shared = SharedBuffer();  // 发送方放弃引用，数据由各缓冲区继续持有
+
+        for (int i = 0; i < outputs; ++i) {
+            int fds[2];
+            require(::pipe(fds) == 0, "pipe failed");
+            ::fcntl(fds[0], F_SETFL, O_NONBLOCK);
+            ::fcntl(fds[1], F_SETFL, O_NONBLOCK);
+            InputBuffer in;
+            while (bufs[i].length() > 0) {
+                require(bufs[i].write_to_fd(fds[1]) >= 0, "write_to_fd failed");
+                while (in.read_from_fd(fds[0]) > 0) {
+                }
+            }
+            std::string_view got = in.peek();
+            require(got.size() == payload.size() + 5, "received size mismatch");
+            require(got.substr(0, 4) == "hdr:" && got.substr(4, payload.size()) == payload &&
+                    got.back() == '\n', "received content mismatch");
+            in.clear();
+            ::close(fds[0]);
+            ::close(fds[1]);
+        }
+        require(pool.get_current_usage() < usage_shared, "shared block not released after last write");
+    }
+    require(pool.get_current_usage() == usage_before, "shared block leaked pool memory");
+
+    // 超出最大规格的负载不经内存池，反复创建后用量不变
+    std::string big(pool.max_chunk_size() + 1000, 'b');
+    for (int round = 0; round < 3; ++round) {
+        SharedBuffer shared(big);
+        require(shared.size() == big.size() &&
+                std::memcmp(shared.data(), big.data(), big.size()) == 0, "oversize shared block content mismatch");
+    }
+    require(pool.get_current_usage() == usage_before, "oversize shared block leaked pool usage");
+    std::cout << "共享数据块测试通过\n\n";
+}
+
+// 全局内存预算：缓冲区按块容量逐级计费，压力等级随占用升降并通知监听者
+void memory_governor_test() {
+    std::cout << "== 内存预算测试 ==\n";
+    MemoryGovernor& governor = MemoryGovernor::instance();
+    PoolConfig config;
+    config.classes = {{4096, 0, 0, 64}};
+    MemoryPool pool(config);
+
+    bool threw = false;
+    try {
+        governor.set_budget(1 << 20, 0.9, 0.5, 0.95);
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    require(threw, "invalid thresholds should throw");
+
+    std::vector<MemoryPressure> seen;
+    int id = governor.add_listener([&seen](MemoryPressure level) { seen.push_back(level); });
+    size_t base = governor.used();
+    governor.set_budget(base + 100 * 4096, 0.5, 0.7, 0.9);
+    require(governor.pressure() == MemoryPressure::kNormal, "initial pressure mismatch");
+
+    MemoryAccount loop_account;
+    {
+        MemoryAccount conn_account(&loop_account);
+        OutputBuffer out(&pool, &conn_account);
+        std::string block(4096, 'x');
+        for (int i = 0; i < 60; ++i) require(out.write_to_buf(block.data(), 4096) == 0, "write failed");
+        require(conn_account.bytes() == 60 * 4096 && loop_account.bytes() == 60 * 4096,
+                "account charge mismatch");
+        require(governor.used() == base + 60 * 4096, "governor usage mismatch");
+        require(governor.pressure() == MemoryPressure::kPauseReads, "expected kPauseReads");
+
+        for (int i = 0; i < 35; ++i) require(out.write_to_buf(block.data(), 4096) == 0, "write failed");
+        require(governor.pressure() == MemoryPressure::kShed, "expected kShed");
+
+        out.pop(40 * 4096);  // 消费掉的块立即撤销计费（逐块回落，依次经过各等级）
+        require(conn_account.bytes() == 55 * 4096, "uncharge on pop mismatch");
+        require(governor.pressure() == MemoryPressure::kPauseReads, "expected pressure to drop");
+
+        // 共享块视图不计费
+        SharedBuffer shared(std::string(8192, 's'));
+        size_t before = conn_account.bytes();
+        require(out.write_to_buf(shared) == 0, "write shared failed");
+        require(conn_account.bytes() == before, "shared view should not be charged");
+    }
+    require(loop_account.bytes() == 0 && governor.used() == base, "buffer destruction did not uncharge");
+    require(governor.pressure() == MemoryPressure::kNormal, "expected kNormal after release");
+
+    const std::vector<MemoryPressure> expected = {
+        MemoryPressure::kPauseReads, MemoryPressure::kStopAccept, MemoryPressure::kShed,
+        MemoryPressure::kStopAccept, MemoryPressure::kPauseReads, MemoryPressure::kNormal,
+    };
+    require(seen == expected, "listener notifications mismatch");
+
+    governor.remove_listener(id);
+    governor.set_budget(0);
+    require(governor.threshold(MemoryPressure::kShed) == static_cast<size_t>(-1), "budget reset mismatch");
+    std::cout << "内存预算测试通过\n\n";
+}
+
+// 文件区间：与内存块混排，write_to_fd按顺序用writev/sendfile发出，文件数据不占用内存池
+void file_range_test() {
+    std::cout << "== 文件区间发送测试 ==\n";
+    char path[] = "/tmp/azh_file_range_XXXXXX";
+    int file = ::mkstemp(path);
+    require(file >= 0, "mkstemp failed");
+    ::unlink(path);
+    std::string content(100000, 'f');
+    for (size_t i = 0; i < content.size(); ++i) content[i] = static_cast<char>('A' + i % 23);
+    require(::write(file, content.data(), content.size()) == static_cast<ssize_t>(content.size()),
+            "file write failed");
+
+    int fds[2];
+    require(::pipe(fds) == 0, "pipe failed");
+    ::fcntl(fds[0], F_SETFL, O_NONBLOCK);
+    ::fcntl(fds[1], F_SETFL, O_NONBLOCK);
+
+    MemoryPool& pool = MemoryPool::get_instance();
+    size_t usage_before = pool.get_current_usage();
+    {
+        OutputBuffer out;
+        require(out.write_to_buf("head:", 5) == 0, "write header failed");
+        require(out.write_file(file, 10, 90000) == 0, "write_file failed");
+        require(out.write_to_buf(":tail", 5) == 0, "write trailer failed");
+        ::close(file);  // 缓冲区持有自己的fd副本
+        require(out.length() == 90010, "file range not counted in length");
+        // 文件区间之后的追加另起新块：两段内存数据各占一个最小块
+        require(pool.get_current_usage() == usage_before + 2 * MEM_SIZES[0], "file range should not use pool memory");
+
+        InputBuffer in;
+        while (out.length() > 0) {
+            require(out.write_to_fd(fds[1]) >= 0, "write_to_fd failed");
+            while (in.read_from_fd(fds[0]) > 0) {
+            }
+        }
+        std::string_view got = in.peek();
+        require(got.size() == 90010, "received size mismatch");
+        require(got.substr(0, 5) == "head:" && got.substr(5, 90000) == std::string_view(content).substr(10, 90000) &&
+                got.substr(90005) == ":tail", "received content mismatch");
+
+        require(out.write_file(-1, 0, 10) == -1, "invalid fd should fail");
+    }
+    require(pool.get_current_usage() == usage_before, "file range test leaked pool memory");
+
+    ::close(fds[0]);
+    ::close(fds[1]);
+    std::cout << "文件区间发送测试通过\n\n";
+}
+
+// loop专属内存池：在线程内按所在NUMA节点构造，缓冲区只从指定池分配和归还，不触及全局单例
+void loop_pool_test(ChunkBacking backing) {
+    std::cout << "== loop专属内存池测试（" << (backing == ChunkBacking::kSlab ? "slab" : "heap") << "） ==\n";
+    int node = current_numa_node();
+    require(node >= -1, "invalid numa node");
+    require(!bind_to_numa_node(nullptr, 4096, 0), "bind of null range should fail");
+
+    std::thread io([backing, node] {
+        PoolConfig config;
+        config.backing = backing;
+        config.numa_node = node;
+        MemoryPool pool(config);
+        MemoryPool& global = MemoryPool::get_instance();
+        size_t global_before = global.get_current_usage();
+        size_t usage_before = pool.get_current_usage();
+
+        std::string payload(200000, 'n');
+        for (size_t i = 0; i < payload.size(); ++i) payload[i] = static_cast<char>('A' + i % 26);
+        {
+            OutputBuffer out(&pool);
+            InputBuffer in(&pool);
+            require(&out.memory_pool() == &pool && &in.memory_pool() == &pool, "buffer not bound to pool");
+            require(out.write_to_buf(payload.data(), static_cast<int>(payload.size())) == 0, "write failed");
+            require(pool.get_current_usage() > usage_before, "loop pool not used");
+
+            int fds[2];
+            require(::pipe(fds) == 0, "pipe failed");
+            ::fcntl(fds[0], F_SETFL, O_NONBLOCK);
+            ::fcntl(fds[1], F_SETFL, O_NONBLOCK);
+            while (out.length() > 0) {
+                require(out.write_to_fd(fds[1]) >= 0, "write_to_fd failed");
+                while (in.read_from_fd(fds[0]) > 0) {
+                }
+            }
+            ::close(fds[0]);
+            ::close(fds[1]);
+            require(in.peek() == payload, "loop pool buffer content mismatch");
+        }
+        require(pool.get_current_usage() == usage_before, "loop pool usage not restored");
+        require(global.get_current_usage() == global_before, "global pool touched by loop buffers");
+    });
+    io.join();
+}
+
 void concurrent_stress_test(size_t thread_count, size_t ops_per_thread) {
     std::cout << "== 并发压力测试 ==\n";
     MemoryPool& pool = MemoryPool::get_instance();
@@ -173,6 +1115,32 @@ int main() {
     try {
         single_thread_basic_test();
         each_size_once_test();
+        thread_cache_test();
+        slab_backing_test();
+        huge_page_test(HugePageMode::kTransparent);
+        huge_page_test(HugePageMode::kExplicit);
+        size_class_config_test();
+        pool_stats_test();
+        pool_allocator_test();
+        bump_arena_test();
+        trim_test(ChunkBacking::kHeap);
+        trim_test(ChunkBacking::kSlab);
+        buffer_chain_test(ReadMode::kExtraBuf);
+        buffer_chain_test(ReadMode::kSpareChunk);
+        extrabuf_small_read_test();
+        oversize_linearize_test();
+        small_max_class_buffer_test();
+        read_alloc_failure_test();
+        buffer_compaction_test();
+        buffer_peek_find_test();
+        shared_block_test();
+        file_range_test();
+        memory_governor_test();
+        loop_pool_test(ChunkBacking::kHeap);
+        loop_pool_test(ChunkBacking::kSlab);
+#ifdef AZH_MEMORY_POISON
+        poison_test();
+#endif
 
         // 并发测试参数：线程数与每线程操作次数
         const size_t threads = 8;
@@ -0,0 +1,341 @@
+// 内存池微基准：分配/归还吞吐、单次操作延迟分位数、缓冲区追加/消费吞吐，均与malloc/new对照
+// 结果以JSON输出（默认标准输出，--out指定文件），用于比较分配器改动前后的数据
+//
+// 用法：memory_pool_microbench [--iters N] [--threads N] [--out FILE]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "memory_pool.hpp"
+#include "data_buf.hpp"
+#include "pr.hpp"
+
+using namespace std::chrono;
+
+namespace {
+
+constexpr size_t LIVE_BYTES_PER_THREAD = 8 * 1024 * 1024;  // 每个线程同时持有的块总大小上限
+constexpr size_t MAX_BATCH = 64;                           // 每轮先连续分配再连续归还的块数上限
+
+struct Options {
+    size_t iterations = 200000;  // 4K规格的分配次数，更大规格按大小等比例减少
+    size_t threads = std::max(2u, std::thread::hardware_concurrency());
+    std::string out;
+};
+
+struct Percentiles {
+    double p50 = 0;
+    double p99 = 0;
+    double p999 = 0;
+};
+
+size_t batch_for(size_t size) {
+    return std::max<size_t>(1, std::min(MAX_BATCH, LIVE_BYTES_PER_THREAD / size));
+}
+
+size_t iterations_for(const Options& opt, size_t size) {
+    return std::max<size_t>(batch_for(size) * 16, opt.iterations * MEM_SIZES[0] / size);
+}
+
+Percentiles percentiles(std::vector<uint32_t>& samples) {
+    Percentiles p;
+    if (samples.empty()) return p;
+    std::sort(samples.begin(), samples.end());
+    auto at = [&samples](double q) {
+        return static_cast<double>(samples[std::min(samples.size() - 1, static_cast<size_t>(q * samples.size()))]);
+    };
+    p.p50 = at(0.50);
+    p.p99 = at(0.99);
+    p.p999 = at(0.999);
+    return p;
+}
+
+// 每页写入一个字节（含最后一个字节）：两种分配器都付出首次触碰物理页的代价，
+// 内存池slab decommit后重新提交、malloc大块走mmap等路径的缺页开销都计入结果
+inline void touch_pages(char* p, size_t size) {
+    constexpr size_t PAGE = 4096;
+    for (size_t off = 0; off < size; off += PAGE) p[off] = 1;
+    p[size - 1] = 1;
+}
+
+// 两种分配器的统一接口：每次分配都触碰整块的每一页，避免只测到未触碰的虚拟内存
+struct PoolAlloc {
+    MemoryPool& pool;
+    size_t size;
+    void* alloc() {
+        Chunk* c = pool.alloc_chunk(size);
+        touch_pages(c->data, size);
+        return c;
+    }
+    void free(void* p) { pool.retrieve(static_cast<Chunk*>(p)); }
+};
+
+struct MallocAlloc {
+    size_t size;
+    void* alloc() {
+        char* p = new char[size];
+        touch_pages(p, size);
+        return p;
+    }
+    void free(void* p) { delete[] static_cast<char*>(p); }
+};
+
+// 分批分配/归还iters次，返回耗时（秒）
+template <typename Alloc>
+double run_batches(Alloc alloc, size_t iters, size_t batch) {
+    std::vector<void*> live(batch);
+    auto start = steady_clock::now();
+    for (size_t done = 0; done < iters; done += batch) {
+        for (size_t i = 0; i < batch; ++i) live[i] = alloc.alloc();
+        for (size_t i = 0; i < batch; ++i) alloc.free(live[i]);
+    }
+    return duration<double>(steady_clock::now() - start).count();
+}
+
+// threads个线程同时执行run_batches，返回总吞吐（百万次分配/秒）
+template <typename MakeAlloc>
+double throughput_mops(MakeAlloc make_alloc, size_t threads, size_t iters, size_t batch) {
+    std::atomic<bool> go{false};
+    std::atomic<size_t> ready{0};
+    std::vector<double> seconds(threads);
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            auto alloc = make_alloc();
+            run_batches(alloc, batch * 4, batch);  // 预热：填充线程缓存与空闲链表
+            ready.fetch_add(1);
+            while (!go.load(std::memory_order_acquire)) {
+            }
+            seconds[t] = run_batches(alloc, iters, batch);
+        });
+    }
+    while (ready.load() < threads) {
+    }
+    go.store(true, std::memory_order_release);
+    for (auto& w : workers) w.join();
+    double slowest = *std::max_element(seconds.begin(), seconds.end());
+    return static_cast<double>(iters * threads) / slowest / 1e6;
+}
+
+// 逐次计时的分配/归还延迟（纳秒，含一次steady_clock读取的开销）
+template <typename Alloc>
+void sample_latency(Alloc alloc, size_t iters, size_t batch,
+                    std::vector<uint32_t>& alloc_ns, std::vector<uint32_t>& free_ns) {
+    std::vector<void*> live(batch);
+    run_batches(alloc, batch * 4, batch);
+    alloc_ns.clear();
+    free_ns.clear();
+    alloc_ns.reserve(iters);
+    free_ns.reserve(iters);
+    for (size_t done = 0; done < iters; done += batch) {
+        for (size_t i = 0; i < batch; ++i) {
+            auto t0 = steady_clock::now();
+            live[i] = alloc.alloc();
+            alloc_ns.push_back(static_cast<uint32_t>(duration_cast<nanoseconds>(steady_clock::now() - t0).count()));
+        }
+        for (size_t i = 0; i < batch; ++i) {
+            auto t0 = steady_clock::now();
+            alloc.free(live[i]);
+            free_ns.push_back(static_cast<uint32_t>(duration_cast<nanoseconds>(steady_clock::now() - t0).count()));
+        }
+    }
+}
+
+std::string json_percentiles(const Percentiles& p) {
+    std::ostringstream ss;
+    ss << "{\"p50\": " << p.p50 << ", \"p99\": " << p.p99 << ", \"p999\": " << p.p999 << "}";
+    return ss.str();
+}
+
+// OutputBuffer：追加msg_size字节的消息，每攒满约1MB整体消费一次（模拟写入内核后pop）
+// 对照：std::string追加后从头部erase（连续缓冲区的常见实现）
+void buffer_output_bench(size_t msg_size, size_t total, double& buf_mbps, double& base_mbps) {
+    std::string msg(msg_size, 'm');
+    const size_t drain_at = 1024 * 1024;
+    {
+        OutputBuffer out;
+        auto start = steady_clock::now();
+        for (size_t sent = 0; sent < total; sent += msg_size) {
+            out.write_to_buf(msg.data(), static_cast<int>(msg_size));
+            if (static_cast<size_t>(out.length()) >= drain_at) out.pop(out.length());
+        }
+        out.clear();
+        buf_mbps = static_cast<double>(total) / duration<double>(steady_clock::now() - start).count() / 1e6;
+    }
+    {
+        std::string out;
+        auto start = steady_clock::now();
+        for (size_t sent = 0; sent < total; sent += msg_size) {
+            out.append(msg);
+            if (out.size() >= drain_at) out.erase(0, out.size());
+        }
+        base_mbps = static_cast<double>(total) / duration<double>(steady_clock::now() - start).count() / 1e6;
+    }
+}
+
+// InputBuffer：经pipe读入msg_size字节的消息并逐条消费（含系统调用，反映真实读取路径）
+// 对照：read到栈上临时缓冲区后追加到std::string再erase
+void buffer_input_bench(size_t msg_size, size_t total, double& buf_mbps, double& base_mbps) {
+    int fds[2];
+    if (::pipe(fds) != 0) {
+        buf_mbps = base_mbps = 0;
+        return;
+    }
+    ::fcntl(fds[0], F_SETFL, O_NONBLOCK);
+    std::string msg(msg_size, 'i');
+    size_t rounds = total / msg_size;
+
+    auto feed = [&] {
+        size_t off = 0;
+        while (off < msg_size) {
+            ssize_t n = ::write(fds[1], msg.data() + off, msg_size - off);
+            if (n <= 0) break;
+            off += static_cast<size_t>(n);
+        }
+    };
+
+    {
+        InputBuffer in;
+        auto start = steady_clock::now();
+        for (size_t r = 0; r < rounds; ++r) {
+            feed();
+            while (static_cast<size_t>(in.length()) < msg_size && in.read_from_fd(fds[0]) > 0) {
+            }
+            in.pop(static_cast<int>(msg_size));
+        }
+        buf_mbps = static_cast<double>(rounds * msg_size) / duration<double>(steady_clock::now() - start).count() / 1e6;
+    }
+    {
+        std::string in;
+        std::vector<char> tmp(64 * 1024);
+        auto start = steady_clock::now();
+        for (size_t r = 0; r < rounds; ++r) {
+            feed();
+            while (in.size() < msg_size) {
+                ssize_t n = ::read(fds[0], tmp.data(), tmp.size());
+                if (n <= 0) break;
+                in.append(tmp.data(), static_cast<size_t>(n));
+            }
+            in.erase(0, msg_size);
+        }
+        base_mbps = static_cast<double>(rounds * msg_size) / duration<double>(steady_clock::now() - start).count() / 1e6;
+    }
+    ::close(fds[0]);
+    ::close(fds[1]);
+}
+
+bool parse_options(int argc, char** argv, Options& opt) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) return false;
+        if (arg == "--iters") {
+            opt.iterations = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--threads") {
+            opt.threads = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--out") {
+            opt.out = argv[++i];
+        } else {
+            return false;
+        }
+    }
+    return opt.iterations > 0 && opt.threads > 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parse_options(argc, argv, opt)) {
+        std::cerr << "usage: " << argv[0] << " [--iters N] [--threads N] [--out FILE]\n";
+        return 1;
+    }
+    logger::pr_set_level(logger::LogLevel::ERROR);
+
+    MemoryPool pool{PoolConfig{}};
+    pool.set_max_capacity(std::max<size_t>(opt.threads, 1) * LIVE_BYTES_PER_THREAD * 4);
+
+    std::ostringstream json;
+    json << "{\n  \"config\": {\"iterations\": " << opt.iterations << ", \"threads\": " << opt.threads
+         << ", \"max_batch\": " << MAX_BATCH << "},\n";
+
+    // 1) 各规格的分配/归还吞吐（单线程与N线程共享同一个池）
+    json << "  \"throughput_mops\": [\n";
+    bool first = true;
+    for (size_t size : MEM_SIZES) {
+        size_t batch = batch_for(size);
+        size_t iters = iterations_for(opt, size);
+        for (size_t threads : {size_t{1}, opt.threads}) {
+            double pool_mops = throughput_mops([&] { return PoolAlloc{pool, size}; }, threads, iters, batch);
+            double malloc_mops = throughput_mops([&] { return MallocAlloc{size}; }, threads, iters, batch);
+            json << (first ? "" : ",\n") << "    {\"size\": " << size << ", \"threads\": " << threads
+                 << ", \"pool\": " << pool_mops << ", \"malloc\": " << malloc_mops << "}";
+            first = false;
+            if (opt.threads == 1) break;
+        }
+    }
+    json << "\n  ],\n";
+
+    // 2) 单次alloc_chunk/retrieve的延迟分位数
+    json << "  \"latency_ns\": [\n";
+    first = true;
+    std::vector<uint32_t> alloc_ns;
+    std::vector<uint32_t> free_ns;
+    for (size_t size : MEM_SIZES) {
+        size_t batch = batch_for(size);
+        size_t iters = iterations_for(opt, size);
+        sample_latency(PoolAlloc{pool, size}, iters, batch, alloc_ns, free_ns);
+        Percentiles pool_alloc = percentiles(alloc_ns);
+        Percentiles pool_free = percentiles(free_ns);
+        sample_latency(MallocAlloc{size}, iters, batch, alloc_ns, free_ns);
+        Percentiles malloc_alloc = percentiles(alloc_ns);
+        Percentiles malloc_free = percentiles(free_ns);
+        json << (first ? "" : ",\n") << "    {\"size\": " << size
+             << ", \"alloc\": {\"pool\": " << json_percentiles(pool_alloc)
+             << ", \"malloc\": " << json_percentiles(malloc_alloc) << "}"
+             << ", \"free\": {\"pool\": " << json_percentiles(pool_free)
+             << ", \"malloc\": " << json_percentiles(malloc_free) << "}}";
+        first = false;
+    }
+    json << "\n  ],\n";
+
+    // 3) 缓冲区追加/消费吞吐（MB/s）
+    json << "  \"buffers_mbps\": [\n";
+    first = true;
+    const size_t total = std::max<size_t>(opt.iterations, 1000) * 1024;
+    for (size_t msg_size : {size_t{64}, size_t{1024}, size_t{16384}}) {
+        double buf_mbps = 0, base_mbps = 0;
+        buffer_output_bench(msg_size, total, buf_mbps, base_mbps);
+        json << (first ? "" : ",\n") << "    {\"name\": \"OutputBuffer.append_drain\", \"msg_size\": " << msg_size
+             << ", \"buffer\": " << buf_mbps << ", \"std_string\": " << base_mbps << "}";
+        first = false;
+        buffer_input_bench(msg_size, total / 8, buf_mbps, base_mbps);
+        json << ",\n    {\"name\": \"InputBuffer.read_drain\", \"msg_size\": " << msg_size
+             << ", \"buffer\": " << buf_mbps << ", \"std_string\": " << base_mbps << "}";
+    }
+    json << "\n  ]\n}\n";
+
+    if (opt.out.empty()) {
+        std::cout << json.str();
+    } else {
+        std::ofstream out(opt.out);
+        out << json.str();
+        if (!out) {
+            std::cerr << "failed to write " << opt.out << "\n";
+            return 1;
+        }
+    }
+    return 0;
+}
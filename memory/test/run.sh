@@ -14,3 +14,8 @@ echo "测试"
 echo "================="
 ./memory_pool_benchmark 
 
+
+echo ""
+echo "微基准（结果写入 build/microbench.json）"
+echo "================="
+./memory_pool_microbench --out microbench.json
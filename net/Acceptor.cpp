@@ -145,6 +145,24 @@ void Acceptor::listen() {
              ip_.c_str(), port_);
 }
 
+void Acceptor::set_trigger_mode(TriggerMode mode) {
+    channel_->set_trigger_mode(mode);
+}
+
+void Acceptor::pause() {
+    if (!listening_ || paused_) return;
+    paused_ = true;
+    channel_->disable_read();
+    LOG_WARN("Acceptor paused on %s:%u\n", ip_.c_str(), port_);
+}
+
+void Acceptor::resume() {
+    if (!listening_ || !paused_) return;
+    paused_ = false;
+    channel_->enable_read();
+    LOG_INFO("Acceptor resumed on %s:%u\n", ip_.c_str(), port_);
+}
+
 // 处理新连接：循环accept获取连接fd，分配IO线程，创建TcpConnection
 void Acceptor::do_accept() {
     while (true) {
@@ -167,12 +185,13 @@ void Acceptor::do_accept() {
         if (connfd < 0) {
             int err = errno;
 
-            if (err == EINTR) {
+            // 连接在accept之前已被对端重置：跳过它继续处理backlog中的其余连接
+            if (err == EINTR || err == ECONNABORTED || err == EPROTO) {
                 continue;
             }
 
             if (err == EAGAIN || err == EWOULDBLOCK) {
-                // ET 模式：必须读到这里才能退出
+                // backlog已取空（边缘触发时必须取到这里才能退出，否则剩余连接不会再触发）
                 break;
             }
 
@@ -203,9 +222,19 @@ void Acceptor::do_accept() {
         auto conn = std::make_shared<TcpConnection>(
             server_, io_loop, connfd, peer, len);
 
+        conn->set_trigger_mode(server_->trigger_mode_);
         conn->set_connected_cb(server_->ts_connected_cb);
         conn->set_message_cb(server_->ts_message_cb);
         conn->set_close_cb(server_->ts_close_cb);
+        if (server_->high_water_mark_cb_) {
+            conn->set_high_water_mark_cb(server_->high_water_mark_cb_, server_->high_water_mark_);
+        }
+        if (server_->low_water_mark_cb_) {
+            conn->set_low_water_mark_cb(server_->low_water_mark_cb_, server_->low_water_mark_);
+        }
+        if (server_->write_complete_cb_) {
+            conn->set_write_complete_cb(server_->write_complete_cb_);
+        }
 
         io_loop->runInLoop([conn]() {
             conn->connect_established();
@@ -9,6 +9,7 @@
 class EventLoop;
 class TcpServer;
 class Channel;
+enum class TriggerMode;
 
 class Acceptor {
 public:
@@ -30,6 +31,14 @@ public:
     // 检查是否正在监听（内联函数，无异常）
     bool is_listening() const noexcept { return listening_; }
 
+    // 设置监听fd的epoll触发方式（须在listen之前调用）；do_accept总是accept到EAGAIN，两种方式都安全
+    void set_trigger_mode(TriggerMode mode);
+
+    // 暂停/恢复接受新连接（只能在所属EventLoop线程调用）：暂停期间新连接留在内核backlog中
+    void pause();
+    void resume();
+    bool is_paused() const noexcept { return paused_; }
+
 private:
     // 私有：处理新连接事件（核心逻辑：调用accept获取新连接fd，回调TcpServer）
     void do_accept();
@@ -48,6 +57,7 @@ private:
     uint16_t port_{0};           // 监听的端口号
 
     bool listening_{false};      // 标记是否正在监听
+    bool paused_{false};         // 标记是否暂停接受新连接
 
     static constexpr int kBacklog = 1024;  // listen系统调用的backlog参数（未完成连接队列长度）
 };
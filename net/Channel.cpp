@@ -1,6 +1,11 @@
 #include "Channel.hpp"
 #include "EventLoop.hpp"
 #include <sys/epoll.h>
+#include <stdexcept>
+
+#ifndef EPOLLEXCLUSIVE
+#define EPOLLEXCLUSIVE (1u << 28)
+#endif
 
 /**
  * @brief 构造函数实现
@@ -17,13 +22,64 @@ Channel::Channel(EventLoop* loop, int fd)
  */
 Channel::~Channel() {}
 
+uint32_t Channel::epoll_events() const {
+    uint32_t ev = events_;
+    if (edge_triggered_) ev |= EPOLLET;
+    if (oneshot_) ev |= EPOLLONESHOT;
+    if (exclusive_) {
+        ev &= ~EPOLLRDHUP;
+        ev |= EPOLLEXCLUSIVE;
+    }
+    return ev;
+}
+
+void Channel::set_trigger_mode(TriggerMode mode) {
+    bool edge = mode == TriggerMode::kEdge;
+    if (edge == edge_triggered_) return;
+    edge_triggered_ = edge;
+    if (events_ != 0) update();
+}
+
+void Channel::set_oneshot(bool on) {
+    if (on == oneshot_) return;
+    if (on && exclusive_) {
+        throw std::invalid_argument("Channel: EPOLLONESHOT cannot be combined with EPOLLEXCLUSIVE");
+    }
+    oneshot_ = on;
+    if (events_ != 0) update();
+}
+
+void Channel::set_exclusive(bool on) {
+    if (on == exclusive_) return;
+    if (on && oneshot_) {
+        throw std::invalid_argument("Channel: EPOLLEXCLUSIVE cannot be combined with EPOLLONESHOT");
+    }
+    exclusive_ = on;
+    if (events_ != 0) update();
+}
+
+void Channel::rearm() {
+    if (events_ != 0) update(true);
+}
+
 /**
  * @brief 启用读事件实现
  */
 void Channel::enable_read() {
+    // 边缘触发下从禁用恢复：即使本轮内刚禁用过（已注册掩码未变）也要执行MOD，内核借此重新检查就绪状态，
+    // 否则暂停期间已到达的数据不会再产生边沿
+    bool reenable = edge_triggered_ && !(events_ & EPOLLIN);
     // 位运算添加读事件：EPOLLIN（可读） + EPOLLRDHUP（对端关闭）
     events_ |= EPOLLIN | EPOLLRDHUP;
     // 同步事件到epoll
+    update(reenable);
+}
+
+/**
+ * @brief 禁用读事件实现
+ */
+void Channel::disable_read() {
+    events_ &= ~(EPOLLIN | EPOLLRDHUP);
     update();
 }
 
@@ -31,9 +87,11 @@ void Channel::enable_read() {
  * @brief 启用写事件实现
  */
 void Channel::enable_write() {
+    // 边缘触发下从禁用恢复同样强制MOD（见enable_read）
+    bool reenable = edge_triggered_ && !(events_ & EPOLLOUT);
     // 位运算添加写事件：EPOLLOUT（可写）
     events_ |= EPOLLOUT;
-    update();
+    update(reenable);
 }
 
 /**
@@ -83,20 +141,18 @@ void Channel::handle_event(uint32_t revents) {
 /**
  * @brief 同步事件到epoll的核心实现
  * @note 1. 必须在EventLoop线程执行，保证线程安全
- *       2. shared_from_this()获取自身shared_ptr，避免回调时Channel被销毁
+ *       2. loop线程内直接传裸指针：已注册的Channel由EventLoop的槽位持有，不需要shared_from_this()的引用计数
+ *       3. 跨线程时才捕获shared_ptr，保证任务执行前Channel不被销毁
  */
-void Channel::update() {
-    // 获取自身的shared_ptr（依赖enable_shared_from_this，需保证Channel由shared_ptr管理）
-    std::shared_ptr<Channel> self = shared_from_this();
-
-    // 检查当前线程是否是EventLoop的线程
+void Channel::update(bool force) {
     if (loop_->is_in_loop_thread()) {
-        // 本线程：直接调用EventLoop更新Channel
-        loop_->update_channel(self);
+        if (force) force_update_ = true;
+        loop_->update_channel(this);
     } else {
         // 非EventLoop线程：将更新操作投递到EventLoop的任务队列，由loop线程执行
-        loop_->runInLoop([self]() {
-            self->loop_->update_channel(self);
+        loop_->runInLoop([self = shared_from_this(), force]() {
+            if (force) self->force_update_ = true;
+            self->loop_->update_channel(self.get());
         });
     }
 }
\ No newline at end of file
@@ -7,6 +7,16 @@
 
 class EventLoop;
 
+/**
+ * @brief epoll触发方式
+ * @details kLevel：水平触发，fd保持就绪时每轮epoll_wait都会报告（默认）
+ *          kEdge：边缘触发（EPOLLET），只在就绪状态变化时报告一次，回调必须读/写到EAGAIN为止
+ */
+enum class TriggerMode {
+    kLevel,
+    kEdge
+};
+
 /**
  * @brief Reactor模式核心组件：IO事件通道
  * @details 单个Channel对应一个文件描述符(fd)，管理其IO事件的注册/更新/处理，
@@ -50,6 +60,41 @@ public:
      */
     uint32_t events() const { return events_; }
 
+    /**
+     * @brief 获取实际注册到epoll的掩码（关注的事件 + 触发方式/ONESHOT/EXCLUSIVE标志）
+     * @note EXCLUSIVE模式下内核只接受EPOLLIN/EPOLLOUT等少数事件位，EPOLLRDHUP被去掉
+     */
+    uint32_t epoll_events() const;
+
+    /**
+     * @brief 设置触发方式（已注册时立即同步到epoll）
+     */
+    void set_trigger_mode(TriggerMode mode);
+    TriggerMode trigger_mode() const { return edge_triggered_ ? TriggerMode::kEdge : TriggerMode::kLevel; }
+    bool is_edge_triggered() const { return edge_triggered_; }
+
+    /**
+     * @brief 启用/关闭EPOLLONESHOT（已注册时立即同步到epoll）
+     * @note 事件报告一次后fd被内核禁用，所有者处理完毕后须调用rearm()重新启用；
+     *       不能与EXCLUSIVE同时使用，否则抛出std::invalid_argument
+     */
+    void set_oneshot(bool on);
+    bool is_oneshot() const { return oneshot_; }
+
+    /**
+     * @brief 启用/关闭EPOLLEXCLUSIVE（多个epoll实例监听同一fd时只唤醒其中一个，避免惊群）
+     * @note 建议在注册前设置；注册后开启或关闭，以及之后的掩码修改，都由Epoll以DEL+ADD完成（内核不允许经MOD增减EXCLUSIVE）；
+     *       不能与ONESHOT同时使用，否则抛出std::invalid_argument
+     */
+    void set_exclusive(bool on);
+    bool is_exclusive() const { return exclusive_; }
+
+    /**
+     * @brief ONESHOT模式下事件处理完毕后重新启用fd（关注的事件不变）
+     * @note enable_read()等接口在掩码未变时不会触发epoll_ctl，重新启用必须调用本接口
+     */
+    void rearm();
+
     /**
      * @brief 设置事件触发时的回调函数
      * @param cb 回调函数（移动语义减少拷贝）
@@ -62,6 +107,12 @@ public:
      */
     void enable_read();
 
+    /**
+     * @brief 禁用读事件（暂停读取，如内存压力下的背压）
+     * @note 同时清除EPOLLRDHUP：暂停期间对端关闭在恢复读取后再处理
+     */
+    void disable_read();
+
     /**
      * @brief 启用写事件（EPOLLOUT）
      */
@@ -93,14 +144,23 @@ public:
 private:
     /**
      * @brief 同步当前events到epoll（核心逻辑，仅内部调用）
+     * @param force 即使掩码与已注册的相同也执行epoll_ctl（ONESHOT重新启用、边缘触发下重新启用读/写）
      * @note 保证操作在EventLoop线程执行，非线程则投递任务到loop队列
      */
-    void update();
+    void update(bool force = false);
+
+    friend class EventLoop;
 
 private:
     EventLoop* loop_;          // 关联的事件循环（不持有所有权，仅引用）
     const int fd_;             // 管理的文件描述符（const：一个Channel仅对应一个fd）
     uint32_t events_{0};       // 要注册到epoll的事件掩码（初始为0）
+    bool edge_triggered_{false};  // 是否边缘触发（EPOLLET）
+    bool oneshot_{false};         // 是否EPOLLONESHOT
+    bool exclusive_{false};       // 是否EPOLLEXCLUSIVE
+    uint32_t registered_events_{0};  // 最近一次同步到epoll的掩码（0表示未注册），仅由EventLoop在loop线程维护
+    bool update_pending_{false};     // 已在EventLoop的待同步列表中
+    bool force_update_{false};       // 下次同步即使掩码未变也执行epoll_ctl（rearm），不清零registered_events_以保留旧掩码
     EventCallback cb_;         // 事件回调函数（由外部设置）
 
     std::weak_ptr<void> tie_;  // 绑定的外部对象（弱引用，不影响其生命周期）
@@ -5,6 +5,10 @@
 #include <logger.hpp>
 #include <cstring> 
 
+#ifndef EPOLLEXCLUSIVE
+#define EPOLLEXCLUSIVE (1u << 28)
+#endif
+
 Epoll::Epoll() {
     epfd_ = ::epoll_create1(EPOLL_CLOEXEC);
     assert(epfd_ >= 0);
@@ -14,21 +18,29 @@ Epoll::~Epoll() {
     ::close(epfd_);
 }
 
-bool Epoll::add(Channel* ch) {
+bool Epoll::add(Channel* ch, uint64_t key) {
     epoll_event ev{};
-    ev.events = ch->events();
-    ev.data.ptr = ch;
+    ev.events = ch->epoll_events();
+    ev.data.u64 = key;
     if (::epoll_ctl(epfd_, EPOLL_CTL_ADD, ch->fd(), &ev) == 0) return true;
     int e = errno;
     LOG_ERROR("epoll_ctl ADD fd=%d failed: %s", ch->fd(), strerror(e));
     return false;
 }
 
-bool Epoll::mod(Channel* ch) {
+bool Epoll::mod(Channel* ch, uint64_t key, uint32_t old_events) {
     epoll_event ev{};
-    ev.events = ch->events();
-    ev.data.ptr = ch;
-    if (::epoll_ctl(epfd_, EPOLL_CTL_MOD, ch->fd(), &ev) == 0) return true;
+    ev.events = ch->epoll_events();
+    ev.data.u64 = key;
+    int rc;
+    if ((ev.events | old_events) & EPOLLEXCLUSIVE) {
+        // 内核拒绝对已带EXCLUSIVE的注册执行MOD，也不允许经MOD加上EXCLUSIVE（EINVAL），只能删除后重新添加
+        rc = ::epoll_ctl(epfd_, EPOLL_CTL_DEL, ch->fd(), nullptr);
+        if (rc == 0) rc = ::epoll_ctl(epfd_, EPOLL_CTL_ADD, ch->fd(), &ev);
+    } else {
+        rc = ::epoll_ctl(epfd_, EPOLL_CTL_MOD, ch->fd(), &ev);
+    }
+    if (rc == 0) return true;
     int e = errno;
     LOG_ERROR("epoll_ctl MOD fd=%d failed: %s", ch->fd(), strerror(e));
     return false;
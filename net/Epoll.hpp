@@ -1,6 +1,7 @@
 #ifndef EPOLL_HPP
 #define EPOLL_HPP
 
+#include <cstdint>
 #include <vector>
 #include <sys/epoll.h>
 
@@ -11,8 +12,10 @@ public:
     Epoll();
     ~Epoll();
 
-    bool  add(Channel* ch);
-    bool  mod(Channel* ch);
+    // key写入epoll_event.data.u64，事件返回时原样带回（由EventLoop编码fd与槽位代数）
+    bool  add(Channel* ch, uint64_t key);
+    // old_events为该fd当前在内核中注册的掩码（新旧任一带EPOLLEXCLUSIVE时以DEL+ADD代替MOD）
+    bool  mod(Channel* ch, uint64_t key, uint32_t old_events);
     bool  del(Channel* ch);
 
     int poll(int timeout_ms, std::vector<epoll_event>& active);
@@ -1,9 +1,11 @@
 #include "EventLoop.hpp"
 #include "Channel.hpp"
 #include "logger.hpp"
+#include "memory_pool.hpp"
 
 #include <sys/eventfd.h>
 #include <unistd.h>
+#include <algorithm>
 #include <cassert>
 #include <cstring>
 #include <errno.h>
@@ -36,6 +38,8 @@ void EventLoop::loop() {
 
     while (running_) {
         do_pending_functors();
+        flush_channel_updates();
+        deferred_releases_.clear();
 
         int n = epoller_.poll(10000, active_events_);
         if (n == static_cast<int>(active_events_.size())) {
@@ -43,23 +47,18 @@ void EventLoop::loop() {
         }
 
         for (int i = 0; i < n; ++i) {
-            auto* raw_ch = static_cast<Channel*>(active_events_[i].data.ptr);
-            if (!raw_ch) continue;
-            int fd = raw_ch->fd(); 
-
-            auto it = channels_.find(fd);
-            if (it != channels_.end()) {
-                auto sp = it->second.lock();
-                if (sp) {
-                    sp->handle_event(active_events_[i].events);
-                } else {
-                    // weak_ptr expired：channel 已被销毁或已从 map 中移除，跳过
-                    LOG_DEBUG("EventLoop: channel expired for fd=%d, skipping event", fd);
-                }
-            } else {
-                // 未找到 weak_ptr（可能是快速 remove），尽量安全地跳过
-                LOG_DEBUG("EventLoop: channel not in map for fd=%d, skipping", fd);
+            uint64_t key = active_events_[i].data.u64;
+            size_t fd = static_cast<uint32_t>(key);
+            uint32_t generation = static_cast<uint32_t>(key >> 32);
+
+            // 回调可能注册新fd使槽位数组扩容，先取出裸指针（Channel由槽位或延迟释放列表保活）
+            Channel* ch = fd < channel_slots_.size() ? channel_slots_[fd].channel.get() : nullptr;
+            if (ch == nullptr || channel_slots_[fd].generation != generation) {
+                // 本轮中该fd已被注销（或关闭后被新连接复用），事件已过期
+                LOG_DEBUG("EventLoop: stale event for fd=%zu, skipping", fd);
+                continue;
             }
+            ch->handle_event(active_events_[i].events);
         }
         do_pending_functors();
     }
@@ -81,12 +80,12 @@ void EventLoop::runInLoop(Functor cb) {
 }
 
 // 向待执行的函数队列中添加函数
+// 入队在前、置位在后：置位失败（已有唤醒在途）时，loop清除标志后的取队列一定能看到本次入队
 void EventLoop::queueInLoop(Functor cb) {
-    {
-        std::lock_guard<std::mutex> lk(mutex_);
-        pending_functors_.push_back(std::move(cb));
+    pending_functors_.push(std::move(cb));
+    if (!wakeup_pending_.exchange(true, std::memory_order_acq_rel)) {
+        wakeup();
     }
-    wakeup();
 }
 
 // 主动触发epoll事件，使跳出epoll_wait阻塞
@@ -118,46 +117,110 @@ void EventLoop::handle_wakeup() {
     }
 }
 
-// 执行待处理的函数
+// 执行待处理的函数：先清除唤醒标志再取出当前全部任务
+// 执行期间新入队的任务（包括任务自己投递的）留到下一轮，其生产者会重新写eventfd使下一次poll立即返回
 void EventLoop::do_pending_functors() {
-    std::vector<Functor> functors;
-    {
-        std::lock_guard<std::mutex> lk(mutex_);
-        functors.swap(pending_functors_);
+    wakeup_pending_.exchange(false, std::memory_order_acq_rel);
+
+    Functor fn;
+    while (pending_functors_.pop(fn)) {
+        running_functors_.push_back(std::move(fn));
     }
-    for (auto& fn : functors) {
-        fn();
+    for (auto& f : running_functors_) {
+        f();
     }
+    running_functors_.clear();
 }
 
 // 更新或添加 Channel 到 epoll 事件循环中
-void EventLoop::update_channel(const std::shared_ptr<Channel>& ch) {
+void EventLoop::update_channel(Channel* ch) {
     int fd = ch->fd();
-    int evs = ch->events();
+    if (fd < 0) return;
 
-    if (evs == 0) {
-        epoller_.del(ch.get());
-        channels_.erase(fd);
+    if (ch->events() == 0) {
+        remove_channel(ch);
         return;
     }
 
-    auto it = channels_.find(fd);
-    if (it == channels_.end()) {
-        if (epoller_.add(ch.get())) {
-            channels_[fd] = ch;
+    if (static_cast<size_t>(fd) < channel_slots_.size() && channel_slots_[fd].channel.get() == ch) {
+        // 已注册：掩码未变则无需系统调用，否则留到poll之前统一同步（同一轮内的多次变化合并为一次MOD）
+        if ((ch->epoll_events() != ch->registered_events_ || ch->force_update_) && !ch->update_pending_) {
+            ch->update_pending_ = true;
+            dirty_channels_.push_back(ch);
+        }
+        return;
+    }
+
+    if (static_cast<size_t>(fd) >= channel_slots_.size()) {
+        channel_slots_.resize(std::max(static_cast<size_t>(fd) + 1, channel_slots_.size() * 2));
+    }
+    ChannelSlot& slot = channel_slots_[fd];
+    uint32_t ev = ch->epoll_events();
+
+    if (slot.channel == nullptr) {
+        ++slot.generation;
+        if (epoller_.add(ch, channel_key(fd, slot.generation))) {
+            slot.channel = ch->shared_from_this();
+            ch->registered_events_ = ev;
+            ch->force_update_ = false;
         } else {
             LOG_ERROR("EventLoop::update_channel add failed fd=%d", fd);
         }
+        return;
+    }
+
+    // 同一fd换了新的Channel（旧Channel未注销）：换代使旧Channel的未决事件失效
+    ++slot.generation;
+    uint32_t old_ev = slot.channel->registered_events_;
+    slot.channel->registered_events_ = 0;
+    deferred_releases_.push_back(std::move(slot.channel));
+    slot.channel = ch->shared_from_this();
+    if (epoller_.mod(ch, channel_key(fd, slot.generation), old_ev)) {
+        ch->registered_events_ = ev;
+        ch->force_update_ = false;
     } else {
-        if (!epoller_.mod(ch.get())) {
-            LOG_ERROR("EventLoop::update_channel mod failed fd=%d", fd);
-        }
+        LOG_ERROR("EventLoop::update_channel mod failed fd=%d", fd);
     }
 }
 
-// 从 epoll 事件循环中移除 Channel
-void EventLoop::remove_channel(const std::shared_ptr<Channel>& ch) {
+// 从 epoll 事件循环中移除 Channel（未注册的Channel忽略）
+void EventLoop::remove_channel(Channel* ch) {
     int fd = ch->fd();
-    channels_.erase(fd);
-    epoller_.del(ch.get());
+    if (fd < 0 || static_cast<size_t>(fd) >= channel_slots_.size()) return;
+
+    ChannelSlot& slot = channel_slots_[fd];
+    if (slot.channel.get() != ch) return;
+    epoller_.del(ch);
+    ch->registered_events_ = 0;
+    ch->force_update_ = false;
+    deferred_releases_.push_back(std::move(slot.channel));
+    slot.channel.reset();
+}
+
+void EventLoop::flush_channel_updates() {
+    for (Channel* ch : dirty_channels_) {
+        ch->update_pending_ = false;
+        int fd = ch->fd();
+        ChannelSlot& slot = channel_slots_[fd];
+        if (slot.channel.get() != ch) continue;  // 同步之前已被注销或替换
+        uint32_t ev = ch->epoll_events();
+        // 本轮内改了又改回（如enable_write后又disable_write）
+        if (ev == ch->registered_events_ && !ch->force_update_) continue;
+        if (epoller_.mod(ch, channel_key(fd, slot.generation), ch->registered_events_)) {
+            ch->registered_events_ = ev;
+            ch->force_update_ = false;
+        } else {
+            LOG_ERROR("EventLoop::flush_channel_updates mod failed fd=%d", fd);
+        }
+    }
+    dirty_channels_.clear();
+}
+
+// 绑定loop专属内存池：池在loop线程中构造，堆块按首次访问落在本线程所在NUMA节点，线程缓存也绑定到本线程
+void EventLoop::set_memory_pool(std::shared_ptr<MemoryPool> pool) {
+    pool_ = std::move(pool);
+}
+
+MemoryPool* EventLoop::memory_pool() const {
+    return pool_ ? pool_.get() : &MemoryPool::get_instance();
 }
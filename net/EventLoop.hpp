@@ -5,17 +5,19 @@
 #include <thread>
 #include <vector>
 #include <functional>
-#include <unordered_map>
-#include <mutex>
 #include <memory>
 
 #include "Epoll.hpp"
+#include "MpscQueue.hpp"
+#include "Task.hpp"
+#include "memory_governor.hpp"
 
 class Channel;
+class MemoryPool;
 
 class EventLoop {
 public:
-    using Functor = std::function<void()>;
+    using Functor = Task;  // 只可移动，常见捕获不分配堆内存
 
     EventLoop();
     ~EventLoop();
@@ -31,13 +33,39 @@ public:
     void runInLoop(Functor cb);
     void queueInLoop(Functor cb);
 
-    void update_channel(const std::shared_ptr<Channel>& ch);
-    void remove_channel(const std::shared_ptr<Channel>& ch);
+    // 以下两个接口只能在loop线程调用（Channel::update负责跨线程投递）
+    // 已注册Channel的掩码变化不立即MOD：记入待同步列表，在下一次epoll_wait之前合并为至多一次epoll_ctl；
+    // 与已注册掩码相同的更新直接忽略。首次注册与注销立即生效
+    void update_channel(Channel* ch);
+    void remove_channel(Channel* ch);
+
+    // 绑定本loop专属的内存池（需在loop线程中、开始服务连接之前调用）
+    void set_memory_pool(std::shared_ptr<MemoryPool> pool);
+    // 本loop的内存池，未绑定时返回全局单例
+    MemoryPool* memory_pool() const;
+    // 本loop专属内存池的所有权（未绑定时为空），连接持有它以保证池比缓冲区活得久
+    std::shared_ptr<MemoryPool> memory_pool_ref() const { return pool_; }
+    // 本loop的缓冲区内存计费账户：各连接账户的上级，汇总后计入全局MemoryGovernor
+    MemoryAccount& memory_account() { return memory_account_; }
 
 private:
+    // fd索引的Channel槽位：注册期间持有Channel，generation在每次注册时递增
+    // epoll事件的data.u64 = generation << 32 | fd，分发时比对代数即可识别fd被关闭又复用后的过期事件，
+    // 不需要哈希查找，也不需要weak_ptr::lock()的引用计数操作
+    struct ChannelSlot {
+        std::shared_ptr<Channel> channel;
+        uint32_t generation{0};
+    };
+
+    static uint64_t channel_key(int fd, uint32_t generation) {
+        return (static_cast<uint64_t>(generation) << 32) | static_cast<uint32_t>(fd);
+    }
+
     void wakeup();
     void handle_wakeup();
     void do_pending_functors();
+    // 把本轮累积的Channel掩码变化同步到epoll（跳过已注销和最终未变的Channel）
+    void flush_channel_updates();
 
 private:
     std::atomic<bool> running_{false};
@@ -49,10 +77,20 @@ private:
     int wakeup_fd_;
     std::shared_ptr<Channel> wakeup_channel_;
 
-    std::mutex mutex_;
-    std::vector<Functor> pending_functors_;
+    // 跨线程任务队列：生产者无锁入队；wakeup_pending_为true表示已有生产者写过eventfd、loop尚未处理，
+    // 此后的入队不再重复写eventfd，只有loop开始处理任务后的第一次入队才付出write()系统调用
+    MpscQueue<Functor> pending_functors_;
+    std::atomic<bool> wakeup_pending_{false};
+    std::vector<Functor> running_functors_;  // do_pending_functors复用的缓冲（仅loop线程访问）
+
+    std::vector<ChannelSlot> channel_slots_;
+    // 注销的Channel延迟到本轮事件分发结束后才释放：Channel可能在自己的事件回调中被注销
+    std::vector<std::shared_ptr<Channel>> deferred_releases_;
+    // 掩码待同步的Channel（裸指针：由槽位或deferred_releases_保活，后者在同步之后才清空）
+    std::vector<Channel*> dirty_channels_;
 
-    std::unordered_map<int, std::weak_ptr<Channel>> channels_;
+    std::shared_ptr<MemoryPool> pool_;
+    MemoryAccount memory_account_;
 };
 
 #endif // EVENT_LOOP_HPP
@@ -0,0 +1,101 @@
+#ifndef MPSC_QUEUE_HPP
+#define MPSC_QUEUE_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <utility>
+
+// 无界无锁多生产者单消费者队列（Vyukov节点链表）
+// 生产者：一次原子exchange挂接节点，不加锁、不等待其他生产者
+// 消费者：只能由一个线程调用pop；某个生产者exchange之后、链接next之前，消费者会暂时看到队列为空，
+//         该生产者完成链接后其元素（以及排在它后面的元素）即可见
+// 节点回收：消费者弹出后把旧哨兵节点压入本队列的空闲栈，生产者优先从空闲栈取节点，稳态下push/pop不再malloc/free
+//   空闲栈头为48位指针+16位版本号（避免ABA）；节点在队列析构前从不释放，生产者读到过期节点的free_next也是安全的
+//   空闲节点数不超过历史上同时在队列中的元素数峰值
+template <typename T>
+class MpscQueue {
+public:
+    MpscQueue() : tail_(new Node), head_(tail_.load(std::memory_order_relaxed)) {}
+
+    ~MpscQueue() {
+        T discard;
+        while (pop(discard)) {
+        }
+        delete head_;
+        Node* n = unpack(free_head_.load(std::memory_order_relaxed));
+        while (n != nullptr) {
+            Node* next = n->free_next.load(std::memory_order_relaxed);
+            delete n;
+            n = next;
+        }
+    }
+
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    // 任意线程调用
+    void push(T value) {
+        Node* node = acquire_node();
+        node->value = std::move(value);
+        Node* prev = tail_.exchange(node, std::memory_order_acq_rel);
+        prev->next.store(node, std::memory_order_release);
+    }
+
+    // 仅消费者线程调用：取出最早的元素，队列为空时返回false
+    bool pop(T& out) {
+        Node* head = head_;
+        Node* next = head->next.load(std::memory_order_acquire);
+        if (next == nullptr) return false;
+        out = std::move(next->value);
+        next->value = T();  // next成为新的哨兵节点，提前释放元素持有的资源
+        head_ = next;
+        release_node(head);
+        return true;
+    }
+
+private:
+    struct Node {
+        std::atomic<Node*> next{nullptr};
+        std::atomic<Node*> free_next{nullptr};  // 空闲栈中的下一个节点
+        T value{};
+    };
+
+    static_assert(sizeof(void*) == 8, "MpscQueue packs a 48-bit pointer and a 16-bit tag into 64 bits");
+    static constexpr int kTagShift = 48;
+    static constexpr uint64_t kPtrMask = (uint64_t{1} << kTagShift) - 1;
+
+    static uint64_t pack(Node* n, uint64_t tag) {
+        return reinterpret_cast<uintptr_t>(n) | (tag << kTagShift);
+    }
+    static Node* unpack(uint64_t v) { return reinterpret_cast<Node*>(v & kPtrMask); }
+    static uint64_t next_tag(uint64_t v) { return (v >> kTagShift) + 1; }
+
+    // 生产者：从空闲栈弹出一个节点，栈空时才new
+    Node* acquire_node() {
+        uint64_t top = free_head_.load(std::memory_order_acquire);
+        while (Node* n = unpack(top)) {
+            Node* next = n->free_next.load(std::memory_order_relaxed);
+            if (free_head_.compare_exchange_weak(top, pack(next, next_tag(top)),
+                                                 std::memory_order_acquire, std::memory_order_acquire)) {
+                return n;
+            }
+        }
+        return new Node;
+    }
+
+    // 消费者：把已弹出的旧哨兵压回空闲栈（其value已在成为哨兵时清空）
+    void release_node(Node* n) {
+        n->next.store(nullptr, std::memory_order_relaxed);
+        uint64_t top = free_head_.load(std::memory_order_relaxed);
+        do {
+            n->free_next.store(unpack(top), std::memory_order_relaxed);
+        } while (!free_head_.compare_exchange_weak(top, pack(n, next_tag(top)),
+                                                   std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    alignas(64) std::atomic<Node*> tail_;  // 生产者挂接端
+    alignas(64) Node* head_;               // 消费者弹出端（哨兵节点）
+    alignas(64) std::atomic<uint64_t> free_head_{0};  // 空闲节点栈（版本号+指针）
+};
+
+#endif // MPSC_QUEUE_HPP
@@ -1,11 +1,15 @@
 #include "TcpConnection.hpp"
+#include "logger.hpp"
 
 #include <unistd.h>
+#include <fcntl.h>
 #include <arpa/inet.h>
 #include <errno.h>
 #include <string.h>
 #include <sstream>
 
+std::atomic<uint64_t> TcpConnection::next_id_{0};
+
 // 构造函数：初始化连接核心参数，关联TcpServer、IO线程EventLoop，记录连接fd和对端地址
 TcpConnection::TcpConnection(TcpServer* server,
                              EventLoop* loop,
@@ -16,7 +20,13 @@ TcpConnection::TcpConnection(TcpServer* server,
       loop_(loop),
       connfd_(connfd),
       peer_addr_(peer),
-      peer_len_(peer_len) {
+      peer_len_(peer_len),
+      pool_(loop->memory_pool_ref()),
+      account_(&loop->memory_account()),
+      input_buf_(loop->memory_pool(), &account_),
+      output_buf_(loop->memory_pool(), &account_),
+      arena_(loop->memory_pool()),
+      id_(next_id_.fetch_add(1, std::memory_order_relaxed)) {
 }
 
 // 析构函数：空实现（连接资源在handle_close中释放，避免double free）
@@ -29,6 +39,7 @@ void TcpConnection::connect_established() {
     // 创建Channel管理连接fd，绑定事件回调
     channel_ = std::make_shared<Channel>(loop_, connfd_);
     channel_->set_callback([self](uint32_t events){ self->handle_event(events); });
+    channel_->set_trigger_mode(trigger_mode_);
     channel_->enable_read();  // 启用读事件（监听数据到达）
     
     channel_->tie(self);  // 绑定self，避免Channel回调时TcpConnection已销毁
@@ -63,35 +74,73 @@ void TcpConnection::handle_event(uint32_t events) {
 }
 
 // 处理读事件：从fd读取数据到输入缓冲区，触发消息回调
+// 水平触发时每次事件只读一次（剩余数据下一轮再报告）；边缘触发时必须读到EAGAIN，否则剩余数据不会再触发
 void TcpConnection::handle_read() {
-    // 从fd读取数据到input_buf_
-    int n = input_buf_.read_from_fd(connfd_);
-    if (n > 0) {
-        // 有数据，触发消息回调（交给上层处理）
-        if (message_cb_) {
-            message_cb_(shared_from_this(), input_buf_);
+    const bool edge = trigger_mode_ == TriggerMode::kEdge;
+    while (true) {
+        // 全局缓冲区内存吃紧：不再读入新数据，等TcpServer在压力回落后恢复（重新启用读事件时内核会重新检查就绪状态）
+        if (MemoryGovernor::instance().pressure() >= MemoryPressure::kPauseReads) {
+            reading_paused_ = true;
+            channel_->disable_read();
+            return;
+        }
+
+        // 从fd读取数据到input_buf_
+        int n = input_buf_.read_from_fd(connfd_);
+        if (n > 0) {
+            // 有数据，触发消息回调（交给上层处理）
+            if (message_cb_) {
+                message_cb_(shared_from_this(), input_buf_);
+                arena_.reset();  // 本条消息的临时对象全部作废，块留给下一条消息复用
+            }
+            // 回调中可能已关闭连接或暂停读取
+            if (!edge || !channel_ || reading_paused_) return;
+        } else if (n == 0) {
+            // 对端关闭（EOF），处理连接关闭
+            handle_close();
+            return;
+        } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            // 内核中暂无数据（已读空，或水平触发下的虚假唤醒）
+            return;
+        } else {
+            // 读错误，或输入缓冲区内存不足（ENOMEM，已读出的数据无处存放），关闭连接
+            handle_error();
+            return;
         }
-    } else if (n == 0) {
-        // 对端关闭（EOF），处理连接关闭
-        handle_close();
-    } else {
-        // 读错误，处理错误
-        handle_error();
     }
 }
 
 // 处理写事件：将输出缓冲区数据写入fd，写完禁用写事件
+// 边缘触发时写到缓冲区为空或EAGAIN为止
 void TcpConnection::handle_write() {
-    // 写缓冲区数据到fd
-    int n = output_buf_.write_to_fd(connfd_);
-    if (n < 0) {
-        handle_error();
-        return;
+    const bool edge = trigger_mode_ == TriggerMode::kEdge;
+    // 写缓冲区数据到fd（write_to_fd返回0表示EAGAIN）
+    int n;
+    do {
+        n = output_buf_.write_to_fd(connfd_);
+        if (n < 0) {
+            handle_error();
+            return;
+        }
+    } while (edge && n > 0 && output_buf_.length() > 0);
+
+    // 越过高水位后回落到低水位：通知生产者恢复发送
+    size_t remaining = static_cast<size_t>(output_buf_.length());
+    if (above_high_water_ && remaining <= low_water_mark_) {
+        above_high_water_ = false;
+        if (low_water_mark_cb_) {
+            loop_->queueInLoop([self = shared_from_this(), cb = low_water_mark_cb_, remaining] {
+                cb(self, remaining);
+            });
+        }
     }
 
     // 缓冲区已空，禁用写事件（避免epoll频繁触发）
-    if (output_buf_.length() == 0) {
+    if (remaining == 0) {
         channel_->disable_write();
+        if (write_complete_cb_) {
+            loop_->queueInLoop([self = shared_from_this(), cb = write_complete_cb_] { cb(self); });
+        }
         // 若处于断开中状态，关闭写端（半关闭）
         if (state_.load() == State::kDisconnecting) {
             ::shutdown(connfd_, SHUT_WR);
@@ -101,10 +150,13 @@ void TcpConnection::handle_write() {
 
 // 处理连接关闭：更新状态、清理Channel、触发关闭回调、关闭fd
 void TcpConnection::handle_close() {
-    // 原子更新状态（仅当当前是已连接时才处理，避免重复关闭）
+    // 原子更新状态（仅当当前是已连接/正在断开时才处理，避免重复关闭）
     State expected = State::kConnected;
     if (!state_.compare_exchange_strong(expected, State::kDisconnected)) {
-        return;
+        expected = State::kDisconnecting;
+        if (!state_.compare_exchange_strong(expected, State::kDisconnected)) {
+            return;
+        }
     }
 
     // 禁用Channel所有事件并释放
@@ -167,9 +219,105 @@ void TcpConnection::sendInLoop(const char* data, size_t len) {
 
     // 未写完的数据存入输出缓冲区，启用写事件（等待fd可写）
     if (static_cast<size_t>(n) < len) {
-        output_buf_.write_to_buf(data + n, len - n);
-        channel_->enable_write();
+        size_t old_len = static_cast<size_t>(output_buf_.length());
+        int rc = output_buf_.write_to_buf(data + n, static_cast<int>(len - n));
+        after_append(old_len, rc);
+    } else if (write_complete_cb_) {
+        loop_->queueInLoop([self = shared_from_this(), cb = write_complete_cb_] { cb(self); });
+    }
+}
+
+void TcpConnection::after_append(size_t old_len, int rc) {
+    if (rc != 0) {
+        LOG_ERROR("TcpConnection fd=%d failed to buffer output (%zu bytes pending), closing\n",
+                  connfd_, old_len);
+        handle_error();
+        return;
+    }
+    channel_->enable_write();
+
+    size_t new_len = static_cast<size_t>(output_buf_.length());
+    if (old_len < high_water_mark_ && new_len >= high_water_mark_) {
+        above_high_water_ = true;
+        if (high_water_mark_cb_) {
+            loop_->queueInLoop([self = shared_from_this(), cb = high_water_mark_cb_, new_len] {
+                cb(self, new_len);
+            });
+        }
+    }
+}
+
+// 发送共享数据块：跨线程时只拷贝句柄（引用计数+1），不拷贝数据
+bool TcpConnection::send(const SharedBuffer& buf) {
+    if (state_.load() != State::kConnected) return false;
+    if (buf.empty()) return true;
+
+    if (loop_->is_in_loop_thread()) {
+        sendInLoop(buf);
+    } else {
+        auto self = shared_from_this();
+        loop_->queueInLoop([self, buf] {
+            self->sendInLoop(buf);
+        });
     }
+    return true;
+}
+
+// IO线程内发送共享数据块：先尝试直接写，剩余部分以只读视图挂接到写缓冲区
+void TcpConnection::sendInLoop(const SharedBuffer& buf) {
+    if (state_.load() != State::kConnected) return;
+
+    ssize_t n = 0;
+    if (output_buf_.length() == 0) {
+        n = ::write(connfd_, buf.data(), buf.size());
+        if (n < 0) {
+            if (errno != EAGAIN) {
+                handle_error();
+                return;
+            }
+            n = 0;
+        }
+    }
+
+    if (static_cast<size_t>(n) < buf.size()) {
+        size_t old_len = static_cast<size_t>(output_buf_.length());
+        int rc = output_buf_.write_to_buf(buf, static_cast<size_t>(n));
+        after_append(old_len, rc);
+    } else if (write_complete_cb_) {
+        loop_->queueInLoop([self = shared_from_this(), cb = write_complete_cb_] { cb(self); });
+    }
+}
+
+// 发送文件区间：跨线程时先复制fd，保证调用方返回后关闭fd不影响发送
+bool TcpConnection::send_file(int fd, off_t offset, size_t len) {
+    if (state_.load() != State::kConnected) return false;
+    if (len == 0) return true;
+
+    if (loop_->is_in_loop_thread()) {
+        sendFileInLoop(fd, offset, len);
+    } else {
+        int dup_fd = ::fcntl(fd, F_DUPFD_CLOEXEC, 0);
+        if (dup_fd < 0) {
+            LOG_ERROR("TcpConnection fd=%d send_file: dup(%d) failed: %s\n",
+                      connfd_, fd, strerror(errno));
+            return false;
+        }
+        auto self = shared_from_this();
+        loop_->queueInLoop([self, dup_fd, offset, len] {
+            self->sendFileInLoop(dup_fd, offset, len);
+            ::close(dup_fd);
+        });
+    }
+    return true;
+}
+
+// IO线程内发送文件区间：挂接到输出缓冲区链尾，由handle_write中的sendfile送出
+void TcpConnection::sendFileInLoop(int fd, off_t offset, size_t len) {
+    if (state_.load() != State::kConnected) return;
+
+    size_t old_len = static_cast<size_t>(output_buf_.length());
+    int rc = output_buf_.write_file(fd, offset, len);
+    after_append(old_len, rc);
 }
 
 // 对外断开连接接口：投递到IO线程执行
@@ -193,6 +341,37 @@ void TcpConnection::shutdownInLoop() {
     }
 }
 
+// 立即关闭：不等待输出缓冲区发完
+void TcpConnection::force_close() {
+    State s = state_.load();
+    if (s == State::kConnected || s == State::kDisconnecting) {
+        auto self = shared_from_this();
+        loop_->runInLoop([self] {
+            self->handle_close();
+        });
+    }
+}
+
+void TcpConnection::pause_reading() {
+    auto self = shared_from_this();
+    loop_->runInLoop([self] {
+        if (self->channel_ && !self->reading_paused_) {
+            self->reading_paused_ = true;
+            self->channel_->disable_read();
+        }
+    });
+}
+
+void TcpConnection::resume_reading() {
+    auto self = shared_from_this();
+    loop_->runInLoop([self] {
+        if (self->channel_ && self->reading_paused_) {
+            self->reading_paused_ = false;
+            self->channel_->enable_read();
+        }
+    });
+}
+
 // 转换对端地址为"IP:端口"字符串（如127.0.0.1:8080）
 std::string TcpConnection::peer_ipport() const {
     char ipbuf[64];
@@ -9,6 +9,7 @@
 #include <netinet/in.h>
 
 #include "data_buf.hpp"
+#include "bump_arena.hpp"
 #include "EventLoop.hpp"
 #include "Channel.hpp"
 
@@ -22,6 +23,11 @@ public:
     using ConnectedCallback = std::function<void(Ptr)>;    // 连接建立回调：连接成功后触发
     using MessageCallback   = std::function<void(Ptr, InputBuffer&)>;    // 消息回调：收到数据后触发（携带输入缓冲区）
     using CloseCallback     = std::function<void(Ptr)>;    // 关闭回调：连接关闭后触发
+    using HighWaterMarkCallback = std::function<void(Ptr, size_t)>;  // 高水位回调：待发送数据涨到高水位时触发（携带当前待发送字节数）
+    using LowWaterMarkCallback  = std::function<void(Ptr, size_t)>;  // 低水位回调：越过高水位后待发送数据回落到低水位时触发
+    using WriteCompleteCallback = std::function<void(Ptr)>;          // 写完成回调：待发送数据全部写入内核后触发
+
+    static constexpr size_t DEFAULT_HIGH_WATER_MARK = 64 * 1024 * 1024;  // 默认高水位（字节）
 
 
     // 连接状态枚举：生命周期状态机
@@ -50,12 +56,51 @@ public:
     void set_message_cb(MessageCallback cb)     { message_cb_   = std::move(cb); }
     void set_close_cb(CloseCallback cb)         { close_cb_     = std::move(cb); }
 
+    // 背压：生产者在高水位回调中暂停发送，在低水位/写完成回调中恢复，避免慢客户端撑爆内存
+    // 回调均经queueInLoop在IO线程中异步触发（不在send()调用栈内重入）；须在连接建立前设置
+    void set_high_water_mark_cb(HighWaterMarkCallback cb, size_t high_water_mark = DEFAULT_HIGH_WATER_MARK) {
+        high_water_mark_cb_ = std::move(cb);
+        high_water_mark_ = high_water_mark;
+    }
+    void set_low_water_mark_cb(LowWaterMarkCallback cb, size_t low_water_mark = 0) {
+        low_water_mark_cb_ = std::move(cb);
+        low_water_mark_ = low_water_mark;
+    }
+    void set_write_complete_cb(WriteCompleteCallback cb) { write_complete_cb_ = std::move(cb); }
+
+    // epoll触发方式（默认水平触发）；边缘触发时读/写事件处理到EAGAIN为止，须在连接建立前设置
+    void set_trigger_mode(TriggerMode mode) { trigger_mode_ = mode; }
+    TriggerMode trigger_mode() const { return trigger_mode_; }
+
+    // 输出缓冲区中待发送的字节数（只能在IO线程中调用）
+    size_t output_buffer_length() const { return static_cast<size_t>(output_buf_.length()); }
+
     // 发送数据（对外接口）
     bool send(const char* data, size_t len);
     bool send(const std::string& data) { return send(data.data(), data.size()); }
+    // 发送共享数据块（广播场景：多个连接共享同一份数据，跨线程投递也只增加引用计数）
+    bool send(const SharedBuffer& buf);
+    // 发送文件区间[offset, offset+len)：排在此前的数据之后，由sendfile直接从页缓存发出，不读入用户态
+    // 连接持有fd的副本，调用返回后即可关闭fd；待发送字节数（水位）包含尚未发出的文件数据
+    bool send_file(int fd, off_t offset, size_t len);
 
     // 关闭连接（触发断开流程）
     void shutdown();
+    // 立即关闭连接（丢弃未发送数据），用于内存压力下的连接削减；线程安全
+    void force_close();
+
+    // 暂停/恢复从socket读取（内存压力背压）；线程安全，实际操作在IO线程中执行
+    void pause_reading();
+    void resume_reading();
+
+    // 本连接缓冲区当前持有的内存块容量（字节，线程安全）
+    size_t buffered_bytes() const { return account_.bytes(); }
+    // 连接序号：按创建先后递增，越小越老
+    uint64_t id() const { return id_; }
+
+    // 本连接的请求分配区：消息回调处理一条消息期间的临时对象从这里分配，回调返回后整体reset
+    // 只能在IO线程（消息回调）中使用，回调返回后其中的内存全部失效
+    BumpArena& arena() { return arena_; }
 
     // 获取连接fd（对外只读）
     int fd() const { return connfd_; }
@@ -86,8 +131,12 @@ private:
 
     // IO线程内发送数据（实际发送逻辑，避免跨线程操作）
     void sendInLoop(const char* data, size_t len);
+    void sendInLoop(const SharedBuffer& buf);
+    void sendFileInLoop(int fd, off_t offset, size_t len);
     // IO线程内关闭连接（实际断开逻辑）
     void shutdownInLoop();
+    // 追加待发送数据后检查高水位；追加失败（内存池耗尽）时关闭连接而不是静默丢数据
+    void after_append(size_t old_len, int rc);
 
 private:
     TcpServer* server_;          // 关联的TcpServer（裸指针，仅使用权）
@@ -98,12 +147,26 @@ private:
     socklen_t peer_len_;         // 对端地址长度
 
     std::shared_ptr<Channel> channel_;  // 管理connfd_的Channel（TcpConnection持有所有权）
+    std::shared_ptr<MemoryPool> pool_;  // 所属loop的专属内存池（未绑定时为空，用全局单例），须在缓冲区之前声明以后于其析构
+    MemoryAccount account_;      // 缓冲区内存计费账户（上级为所属loop的账户），同样须在缓冲区之前声明
     InputBuffer  input_buf_;     // 读缓冲区：存储从fd读取的未处理数据
     OutputBuffer output_buf_;    // 写缓冲区：存储待写入fd的数据
+    BumpArena    arena_;         // 请求分配区：每次消息回调返回后reset
 
     ConnectedCallback connected_cb_;    // 连接建立回调
     MessageCallback   message_cb_;      // 消息回调
     CloseCallback     close_cb_;        // 关闭回调
+    HighWaterMarkCallback high_water_mark_cb_;  // 高水位回调
+    LowWaterMarkCallback  low_water_mark_cb_;   // 低水位回调
+    WriteCompleteCallback write_complete_cb_;   // 写完成回调
+    size_t high_water_mark_{DEFAULT_HIGH_WATER_MARK};
+    size_t low_water_mark_{0};
+    bool above_high_water_{false};   // 已越过高水位、尚未回落到低水位（仅IO线程访问）
+    bool reading_paused_{false};     // 因内存压力暂停了读取（仅IO线程访问）
+    TriggerMode trigger_mode_{TriggerMode::kLevel};  // Channel的epoll触发方式
+    const uint64_t id_;              // 连接序号
+
+    static std::atomic<uint64_t> next_id_;
 
     std::atomic<State> state_{State::kConnecting};  // 连接状态（原子变量，线程安全）
 };
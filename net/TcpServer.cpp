@@ -142,10 +142,23 @@ void TcpServer::start() {
 
     // 3) 创建Acceptor（监听fd的核心组件，运行在base_loop）
     acceptor_ = std::make_unique<Acceptor>(this, base_loop_, ip_, port_);
+    acceptor_->set_trigger_mode(trigger_mode_);
 
     // 4) 开始监听端口（注册监听事件到base_loop）
     acceptor_->listen();
 
+    // 5) 监听全局内存压力：等级变化时投递到base_loop处理（回调在计费线程中，不能直接操作acceptor/连接表）
+    memory_listener_token_ = std::make_shared<bool>(true);
+    std::weak_ptr<bool> token = memory_listener_token_;
+    memory_listener_id_ = MemoryGovernor::instance().add_listener([this, token](MemoryPressure) {
+        base_loop_->queueInLoop([this, token] {
+            if (token.lock()) apply_memory_pressure();
+        });
+    });
+    base_loop_->runInLoop([this, token] {
+        if (token.lock()) apply_memory_pressure();
+    });
+
     LOG_INFO("TcpServer[%s] started on %s:%u, idle_timeout=%s\n", 
              name_.c_str(), ip_.c_str(), port_,
              idle_timeout_enabled_ ? "enabled" : "disabled");
@@ -169,6 +182,13 @@ void TcpServer::stop() {
         idle_manager_.reset();
     }
 
+    // 注销内存压力监听，已投递但未执行的任务随令牌失效
+    if (memory_listener_id_ >= 0) {
+        MemoryGovernor::instance().remove_listener(memory_listener_id_);
+        memory_listener_id_ = -1;
+    }
+    memory_listener_token_.reset();
+
     // 2) 销毁Acceptor（会关闭监听fd）
     acceptor_.reset();
 
@@ -366,4 +386,59 @@ void TcpServer::on_connection_idle_timeout(const TcpConnectionPtr& conn) {
         LOG_ERROR("TcpServer[%s] error closing idle connection fd=%d: %s\n", 
                   name_.c_str(), conn->fd(), e.what());
     }
-}
\ No newline at end of file
+}
+
+// 内部：按当前压力等级施加措施（base_loop线程）
+// 以pressure()的当前值为准而不是通知携带的等级：通知可能乱序或合并
+void TcpServer::apply_memory_pressure() {
+    MemoryGovernor& governor = MemoryGovernor::instance();
+    MemoryPressure level = governor.pressure();
+
+    if (acceptor_) {
+        if (level >= MemoryPressure::kStopAccept) {
+            acceptor_->pause();
+        } else {
+            acceptor_->resume();
+        }
+    }
+
+    std::vector<TcpConnectionPtr> conns;
+    {
+        std::lock_guard<std::mutex> lk(conn_mutex_);
+        conns.reserve(connections_.size());
+        for (auto& [fd, conn] : connections_) {
+            if (conn) conns.push_back(conn);
+        }
+    }
+
+    // 压力回落：恢复此前被暂停读取的连接（暂停是在各连接的读事件中按需进行的）
+    if (level < MemoryPressure::kPauseReads) {
+        for (auto& conn : conns) {
+            conn->resume_reading();
+        }
+        return;
+    }
+    if (level != MemoryPressure::kShed) return;
+
+    // 削减：缓冲区占用大的优先，相同时先关老连接，直到预计占用回落到停止accept阈值以下
+    std::sort(conns.begin(), conns.end(), [](const TcpConnectionPtr& a, const TcpConnectionPtr& b) {
+        size_t ba = a->buffered_bytes();
+        size_t bb = b->buffered_bytes();
+        return ba != bb ? ba > bb : a->id() < b->id();
+    });
+
+    size_t used = governor.used();
+    const size_t target = governor.threshold(MemoryPressure::kStopAccept);
+    size_t shed = 0;
+    for (auto& conn : conns) {
+        if (used < target) break;
+        size_t bytes = conn->buffered_bytes();
+        LOG_WARN("TcpServer[%s] memory pressure: shedding connection fd=%d (%zu buffered bytes)\n",
+                 name_.c_str(), conn->fd(), bytes);
+        conn->force_close();
+        used -= std::min(used, bytes);
+        ++shed;
+    }
+    LOG_WARN("TcpServer[%s] memory pressure: shed %zu connections, %zu/%zu bytes in use\n",
+             name_.c_str(), shed, governor.used(), governor.budget());
+}
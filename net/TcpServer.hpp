@@ -26,6 +26,9 @@ public:
     using CloseCallback      = std::function<void(const TcpConnectionPtr&)>;
     using DataCallback       = std::function<void(const TcpConnectionPtr&, const char*, size_t)>;
     using ThreadInitCallback = std::function<void(EventLoop*)>;
+    using HighWaterMarkCallback = std::function<void(const TcpConnectionPtr&, size_t)>;
+    using LowWaterMarkCallback  = std::function<void(const TcpConnectionPtr&, size_t)>;
+    using WriteCompleteCallback = std::function<void(const TcpConnectionPtr&)>;
 
     /**
      * @param base_loop 主 EventLoop（通常在主线程，用来 accept）
@@ -64,12 +67,44 @@ public:
         thread_init_cb_ = cb;
     }
 
+    // 为每个IO线程创建专属内存池，连接缓冲区从所属loop的池分配（必须在start之前调用）
+    void set_loop_memory_pool(const PoolConfig& config) {
+        thread_pool_->set_loop_memory_pool(config);
+    }
+
     // Setters for user callbacks
     void set_connection_callback(ConnectionCallback cb) { user_conn_cb_ = std::move(cb); }
     void set_message_callback(MessageCallback cb)       { user_msg_cb_ = std::move(cb); }
     void set_close_callback(CloseCallback cb)           { user_close_cb_ = std::move(cb); }
     void set_data_callback(DataCallback cb)             { user_data_cb_ = std::move(cb); }
 
+    // 输出背压回调（对之后建立的每个连接生效，见TcpConnection::set_high_water_mark_cb）
+    void set_high_water_mark_callback(HighWaterMarkCallback cb,
+                                      size_t high_water_mark = TcpConnection::DEFAULT_HIGH_WATER_MARK) {
+        high_water_mark_cb_ = std::move(cb);
+        high_water_mark_ = high_water_mark;
+    }
+    void set_low_water_mark_callback(LowWaterMarkCallback cb, size_t low_water_mark = 0) {
+        low_water_mark_cb_ = std::move(cb);
+        low_water_mark_ = low_water_mark;
+    }
+    void set_write_complete_callback(WriteCompleteCallback cb) { write_complete_cb_ = std::move(cb); }
+
+    // epoll触发方式（监听fd与之后建立的每个连接都使用该方式，默认水平触发）；必须在start之前调用
+    // 边缘触发下busy连接不会在每轮epoll_wait中反复报告，读/写事件处理到EAGAIN为止
+    void set_trigger_mode(TriggerMode mode) { trigger_mode_ = mode; }
+    TriggerMode trigger_mode() const { return trigger_mode_; }
+
+    // 全局缓冲区内存预算（转发给MemoryGovernor，0表示不限制）；越过各级阈值时依次：
+    // 暂停连接读取 → 停止accept → 按缓冲区占用从大到小（相同时先老后新）强制关闭连接
+    void set_memory_budget(size_t budget_bytes,
+                           double pause_reads_ratio = MemoryGovernor::DEFAULT_PAUSE_READS_RATIO,
+                           double stop_accept_ratio = MemoryGovernor::DEFAULT_STOP_ACCEPT_RATIO,
+                           double shed_ratio = MemoryGovernor::DEFAULT_SHED_RATIO) {
+        MemoryGovernor::instance().set_budget(budget_bytes, pause_reads_ratio,
+                                              stop_accept_ratio, shed_ratio);
+    }
+
     // 统计信息
     size_t connection_count() const;
     size_t idle_connection_count() const;
@@ -95,6 +130,9 @@ private:
     // 空闲连接超时回调
     void on_connection_idle_timeout(const TcpConnectionPtr& conn);
 
+    // 在base_loop中按当前内存压力等级调整accept/读取，必要时削减连接
+    void apply_memory_pressure();
+
 private:
     std::string name_;           // 服务器名称
     EventLoop* base_loop_;       // 不所有权（由外部创建/销毁）
@@ -115,6 +153,12 @@ private:
     CloseCallback      user_close_cb_;
     DataCallback       user_data_cb_;
     ThreadInitCallback thread_init_cb_;
+    HighWaterMarkCallback high_water_mark_cb_;
+    LowWaterMarkCallback  low_water_mark_cb_;
+    WriteCompleteCallback write_complete_cb_;
+    size_t high_water_mark_ = TcpConnection::DEFAULT_HIGH_WATER_MARK;
+    size_t low_water_mark_ = 0;
+    TriggerMode trigger_mode_ = TriggerMode::kLevel;
     // ---------------------------------------------------------
     // 供 Acceptor 直接访问的回调（通过友元关系）
     // ---------------------------------------------------------
@@ -128,6 +172,10 @@ private:
     int idle_timeout_ms_ = 300000; // 默认5分钟
     bool idle_timeout_enabled_ = false;
 
+    // 内存压力监听（MemoryGovernor的监听者id；令牌在stop时释放，使已投递的任务失效）
+    int memory_listener_id_ = -1;
+    std::shared_ptr<bool> memory_listener_token_;
+
     // 服务器状态
     std::atomic<bool> started_{false};
 };
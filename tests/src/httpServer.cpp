@@ -10,6 +10,9 @@
 #include <fstream>
 #include <iostream>
 #include <csignal>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 using namespace std;
 
@@ -118,8 +121,12 @@ private:
         // 发送响应
         string response_str = build_http_response(res);
         conn->send(response_str);
+        if (res.file_fd >= 0) {
+            conn->send_file(res.file_fd, 0, res.file_size);
+            ::close(res.file_fd);
+        }
         
-        stats_.total_bytes_sent += response_str.size();
+        stats_.total_bytes_sent += response_str.size() + res.file_size;
         
         // 清除已处理的数据 - 使用 pop() 而不是 retrieve()
         buffer.pop(request.size());
@@ -141,6 +148,8 @@ private:
         string status_text = "OK";
         unordered_map<string, string> headers;
         string body;
+        int file_fd = -1;        // 静态文件：>=0时以sendfile发送文件内容代替body
+        size_t file_size = 0;
     };
     
     HttpRequest parse_http_request(const string& request) {
@@ -248,7 +257,7 @@ private:
         }
         
         // 设置Content-Length
-        res.headers["Content-Length"] = to_string(res.body.size());
+        res.headers["Content-Length"] = to_string(res.file_fd >= 0 ? res.file_size : res.body.size());
         
         // 设置Content-Type如果没有设置
         if (res.headers.find("Content-Type") == res.headers.end()) {
@@ -391,16 +400,19 @@ private:
             file_path = "./www/index.html";
         }
         
-        ifstream file(file_path, ios::binary);
-        if (!file.is_open()) {
+        int fd = ::open(file_path.c_str(), O_RDONLY | O_CLOEXEC);
+        struct stat st{};
+        if (fd < 0 || ::fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+            if (fd >= 0) ::close(fd);
             res.status_code = 404;
             res.status_text = "Not Found";
             res.body = "404 Not Found\n";
             return res;
         }
         
-        // 读取文件内容
-        string content((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+        // 文件内容不读入内存，由onMessage经send_file直接发送
+        res.file_fd = fd;
+        res.file_size = static_cast<size_t>(st.st_size);
         
         res.status_code = 200;
         res.status_text = "OK";
@@ -424,7 +436,6 @@ private:
             }
         }
         
-        res.body = content;
         return res;
     }
     
@@ -1,5 +1,6 @@
 #include "EventLoopThreadPool.hpp"
 #include "pr.hpp"
+#include "numa.hpp"
 #include <algorithm>
 #include <stdexcept>
 
@@ -36,39 +37,50 @@ void EventLoopThreadPool::start(const ThreadInitCallback& init_cb) {
         return;
     }
     
-    std::lock_guard<std::mutex> lock(mutex_);  // 保护线程列表
+    std::vector<std::future<void>> pools_ready;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);  // 保护线程列表
     
-    threads_.reserve(thread_count_);  // 预分配内存
-    for (int i = 0; i < thread_count_; ++i) {
-        // 创建EventLoop（unique_ptr独占所有权）
-        auto loop = std::make_unique<EventLoop>();
-        auto* loop_ptr = loop.get();
-        
-        // 创建线程数据载体，接管EventLoop所有权
-        auto thread_data = std::make_unique<ThreadData>(std::move(loop));
-        thread_data->running.store(true, std::memory_order_release);
+        threads_.reserve(thread_count_);  // 预分配内存
+        for (int i = 0; i < thread_count_; ++i) {
+            // 创建EventLoop（unique_ptr独占所有权）
+            auto loop = std::make_unique<EventLoop>();
+            auto* loop_ptr = loop.get();
         
-        // 启动工作线程：执行run_in_thread
-        thread_data->thread = std::thread(
-            [this, i, loop_ptr, &init_cb, thread_ptr = thread_data.get()]() {
-                this->run_in_thread(i, init_cb);
-                thread_ptr->running.store(false, std::memory_order_release);
+            // 创建线程数据载体，接管EventLoop所有权
+            auto thread_data = std::make_unique<ThreadData>(std::move(loop));
+            thread_data->running.store(true, std::memory_order_release);
+            if (loop_pool_config_) {
+                pools_ready.push_back(thread_data->pool_ready.get_future());
             }
-        );
         
-        // Linux下设置线程名称（便于调试）
+            // 启动工作线程：执行run_in_thread
+            thread_data->thread = std::thread(
+                [this, i, loop_ptr, &init_cb, thread_ptr = thread_data.get()]() {
+                    this->run_in_thread(i, init_cb);
+                    thread_ptr->running.store(false, std::memory_order_release);
+                }
+            );
+        
+            // Linux下设置线程名称（便于调试）
 #ifdef __linux__
-        std::string thread_name = name_ + "-" + std::to_string(i);
-        pthread_setname_np(thread_data->thread.native_handle(), thread_name.c_str());
+            std::string thread_name = name_ + "-" + std::to_string(i);
+            pthread_setname_np(thread_data->thread.native_handle(), thread_name.c_str());
 #endif
         
-        // 将线程数据存入线程池
-        threads_.push_back(std::move(thread_data));
+            // 将线程数据存入线程池
+            threads_.push_back(std::move(thread_data));
         
-        LOG_INFO("EventLoopThreadPool[%s] started thread %d, loop=%p\n", 
-                 name_.c_str(), i, static_cast<void*>(loop_ptr));
+            LOG_INFO("EventLoopThreadPool[%s] started thread %d, loop=%p\n", 
+                     name_.c_str(), i, static_cast<void*>(loop_ptr));
+        }
     }
-    
+
+    // 等待各IO线程绑定好专属内存池，之后分配到这些loop的连接都从本线程的池取内存
+    for (auto& ready : pools_ready) {
+        ready.wait();
+    }
+
     LOG_INFO("EventLoopThreadPool[%s] started with %zu threads\n", 
              name_.c_str(), threads_.size());
 }
@@ -120,6 +132,7 @@ void EventLoopThreadPool::stop() {
 // 工作线程入口函数：执行初始化回调→运行EventLoop事件循环
 void EventLoopThreadPool::run_in_thread(size_t index, const ThreadInitCallback& init_cb) {
     EventLoop* loop = nullptr;
+    std::promise<void>* pool_ready = nullptr;
     
     // 获取当前线程对应的EventLoop裸指针（不转移所有权）
     {
@@ -128,9 +141,15 @@ void EventLoopThreadPool::run_in_thread(size_t index, const ThreadInitCallback&
             return;
         }
         loop = threads_[index]->loop.get();
+        pool_ready = &threads_[index]->pool_ready;
     }
     
     if (!loop) return;
+
+    // 先绑定专属内存池，再执行用户初始化回调（回调中即可使用loop->memory_pool()）
+    if (loop_pool_config_) {
+        init_loop_memory_pool(loop, *pool_ready);
+    }
     
     // 执行线程初始化回调
     if (init_cb) {
@@ -149,6 +168,22 @@ void EventLoopThreadPool::run_in_thread(size_t index, const ThreadInitCallback&
     }
 }
 
+// 在IO线程内构造内存池：slab按本线程所在NUMA节点mbind，堆块由本线程首次写入而本地化
+// 构造失败时记录错误并退回全局单例池，保证start()不会一直等待
+void EventLoopThreadPool::init_loop_memory_pool(EventLoop* loop, std::promise<void>& ready) {
+    PoolConfig config = *loop_pool_config_;
+    config.numa_node = current_numa_node();
+    try {
+        loop->set_memory_pool(std::make_shared<MemoryPool>(config));
+        LOG_INFO("EventLoopThreadPool[%s] loop=%p bound memory pool on numa node %d\n",
+                 name_.c_str(), static_cast<void*>(loop), config.numa_node);
+    } catch (const std::exception& e) {
+        LOG_ERROR("EventLoopThreadPool[%s] failed to create loop memory pool: %s\n",
+                  name_.c_str(), e.what());
+    }
+    ready.set_value();
+}
+
 // 轮询（Round-Robin）获取下一个EventLoop裸指针（不转移所有权）
 EventLoop* EventLoopThreadPool::get_next_loop() {
     std::lock_guard<std::mutex> lock(mutex_);
@@ -3,6 +3,7 @@
 
 #include "EventLoop.hpp"
 #include "logger.hpp"
+#include "memory_pool.hpp"
 #include <vector>
 #include <memory>
 #include <atomic>
@@ -11,6 +12,7 @@
 #include <functional>
 #include <string>
 #include <future>
+#include <optional>
 
 class EventLoopThreadPool {
 public:
@@ -35,6 +37,13 @@ public:
      * @param init_cb 每个线程启动后的初始化回调
      */
     void start(const ThreadInitCallback& init_cb = nullptr);
+
+    /**
+     * @brief 为每个IO线程创建专属内存池（必须在start之前调用）
+     * @param config 内存池配置，numa_node由各线程按所在节点自动填写
+     * 内存池在IO线程内构造并绑定到其EventLoop，start()返回时所有loop均已绑定完毕
+     */
+    void set_loop_memory_pool(const PoolConfig& config) { loop_pool_config_ = config; }
     
     /**
      * @brief 停止线程池（等待所有线程退出）
@@ -77,6 +86,7 @@ private:
         std::thread thread;
         std::unique_ptr<EventLoop> loop;
         std::atomic<bool> running{false};
+        std::promise<void> pool_ready;  // loop专属内存池绑定完成（或失败）
         
         ThreadData(std::unique_ptr<EventLoop> lp) 
             : loop(std::move(lp)) {}
@@ -84,6 +94,8 @@ private:
     
     // 线程工作函数
     void run_in_thread(size_t index, const ThreadInitCallback& init_cb);
+    // 在IO线程内创建并绑定loop专属内存池
+    void init_loop_memory_pool(EventLoop* loop, std::promise<void>& ready);
     
 private:
     std::string name_;
@@ -92,6 +104,7 @@ private:
     mutable std::mutex mutex_;
     std::atomic<bool> started_{false};
     int thread_count_;
+    std::optional<PoolConfig> loop_pool_config_;
 };
 
 #endif // EVENTLOOPTHREADPOOL_HPP
\ No newline at end of file
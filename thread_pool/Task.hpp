@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// 只可移动的无参任务，替代std::function<void()>用于跨线程投递
+// 可调用对象不超过INLINE_SIZE字节、可无异常移动时直接存放在内部缓冲区（不分配堆内存），
+// 常见捕获（shared_ptr + std::string、shared_ptr + 回调 + 整数等）都在此范围内；更大的对象退化为堆分配
+// 只可移动：可以捕获unique_ptr、packaged_task等只可移动的对象
+class Task {
+public:
+    static constexpr std::size_t INLINE_SIZE = 64;
+
+    Task() noexcept = default;
+    Task(std::nullptr_t) noexcept {}
+
+    template <typename F,
+              typename Fn = std::decay_t<F>,
+              typename = std::enable_if_t<!std::is_same_v<Fn, Task> && std::is_invocable_v<Fn&>>>
+    Task(F&& f) {
+        if constexpr (fits_inline<Fn>()) {
+            ::new (static_cast<void*>(&storage_)) Fn(std::forward<F>(f));
+            ops_ = &inline_ops<Fn>;
+        } else {
+            *reinterpret_cast<Fn**>(&storage_) = new Fn(std::forward<F>(f));
+            ops_ = &heap_ops<Fn>;
+        }
+    }
+
+    Task(Task&& other) noexcept { move_from(other); }
+
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            reset();
+            move_from(other);
+        }
+        return *this;
+    }
+
+    Task& operator=(std::nullptr_t) noexcept {
+        reset();
+        return *this;
+    }
+
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    ~Task() { reset(); }
+
+    explicit operator bool() const noexcept { return ops_ != nullptr; }
+
+    // 调用空任务抛出std::bad_function_call（与std::function一致）
+    void operator()() {
+        if (ops_ == nullptr) throw std::bad_function_call();
+        ops_->invoke(&storage_);
+    }
+
+    // 可调用对象类型F是否不经堆分配存放（供测试与调用方确认热点路径的捕获没有超限）
+    template <typename F>
+    static constexpr bool stores_inline() { return fits_inline<std::decay_t<F>>(); }
+
+private:
+    using Storage = std::aligned_storage_t<INLINE_SIZE, alignof(std::max_align_t)>;
+
+    struct Ops {
+        void (*invoke)(Storage*);
+        void (*move)(Storage* dst, Storage* src) noexcept;  // 移动到dst并销毁src
+        void (*destroy)(Storage*) noexcept;
+    };
+
+    template <typename Fn>
+    static constexpr bool fits_inline() {
+        return sizeof(Fn) <= INLINE_SIZE && alignof(Fn) <= alignof(std::max_align_t) &&
+               std::is_nothrow_move_constructible_v<Fn>;
+    }
+
+    template <typename Fn>
+    static Fn* inline_ptr(Storage* s) { return std::launder(reinterpret_cast<Fn*>(s)); }
+
+    template <typename Fn>
+    static Fn*& heap_ptr(Storage* s) { return *reinterpret_cast<Fn**>(s); }
+
+    template <typename Fn>
+    static constexpr Ops inline_ops = {
+        [](Storage* s) { (*inline_ptr<Fn>(s))(); },
+        [](Storage* dst, Storage* src) noexcept {
+            ::new (static_cast<void*>(dst)) Fn(std::move(*inline_ptr<Fn>(src)));
+            inline_ptr<Fn>(src)->~Fn();
+        },
+        [](Storage* s) noexcept { inline_ptr<Fn>(s)->~Fn(); },
+    };
+
+    template <typename Fn>
+    static constexpr Ops heap_ops = {
+        [](Storage* s) { (*heap_ptr<Fn>(s))(); },
+        [](Storage* dst, Storage* src) noexcept { heap_ptr<Fn>(dst) = heap_ptr<Fn>(src); },
+        [](Storage* s) noexcept { delete heap_ptr<Fn>(s); },
+    };
+
+    void move_from(Task& other) noexcept {
+        if (other.ops_ != nullptr) {
+            other.ops_->move(&storage_, &other.storage_);
+            ops_ = other.ops_;
+            other.ops_ = nullptr;
+        }
+    }
+
+    void reset() noexcept {
+        if (ops_ != nullptr) {
+            ops_->destroy(&storage_);
+            ops_ = nullptr;
+        }
+    }
+
+    Storage storage_;
+    const Ops* ops_{nullptr};
+};
@@ -12,9 +12,12 @@
 #include <memory>
 #include <type_traits>
 
+#include "Task.hpp"
+#include "pr.hpp"
+
 class ThreadPool {
 public:
-    using Task = std::function<void()>;
+    using Task = ::Task;
     static constexpr std::size_t kMaxThreads = 64;
 
     explicit ThreadPool(std::size_t thread_count = std::thread::hardware_concurrency()) {
@@ -46,23 +49,24 @@ public:
             throw std::runtime_error("post_task on stopped ThreadPool");
         }
 
-        auto task = std::make_shared<std::packaged_task<return_type()>>(
+        // Task只可移动，packaged_task直接存入任务内部，不再额外包一层shared_ptr
+        std::packaged_task<return_type()> task(
             std::bind(std::forward<F>(f), std::forward<Args>(args)...)
         );
 
-        std::future<return_type> res = task->get_future();
-        {
-            std::lock_guard<std::mutex> lock(tp_mutex_);
-            if (!tp_run_.load(std::memory_order_relaxed)) {
-                throw std::runtime_error("post_task on stopped ThreadPool");
-            }
-            tp_tasks_.emplace([task]() { (*task)(); });
-        }
-
-        tp_task_cv_.notify_one();
+        std::future<return_type> res = task.get_future();
+        enqueue(Task([task = std::move(task)]() mutable { task(); }));
         return res;
     }
 
+    // 投递不需要返回值的任务（不创建future，常见捕获不分配堆内存）；任务抛出的异常被记录后丢弃
+    void post(Task task) {
+        if (!tp_run_.load(std::memory_order_relaxed)) {
+            throw std::runtime_error("post on stopped ThreadPool");
+        }
+        enqueue(std::move(task));
+    }
+
     int idle_thread_count() const noexcept { 
         return static_cast<int>(tp_idle_count_.load(std::memory_order_acquire)); 
     }
@@ -91,6 +95,18 @@ public:
     }
 
 private:
+    void enqueue(Task task) {
+        {
+            std::lock_guard<std::mutex> lock(tp_mutex_);
+            if (!tp_run_.load(std::memory_order_relaxed)) {
+                throw std::runtime_error("post_task on stopped ThreadPool");
+            }
+            tp_tasks_.push(std::move(task));
+        }
+
+        tp_task_cv_.notify_one();
+    }
+
     void add_threads(std::size_t count) {
         std::lock_guard<std::mutex> lock(tp_mutex_);
         std::size_t threads_to_create = std::min(count, kMaxThreads - tp_pool_.size());
@@ -121,8 +137,14 @@ private:
                 tp_idle_count_.fetch_sub(1, std::memory_order_acq_rel);
             }
 
-            // 直接执行任务，异常会自动存储到future
-            task();
+            // post_task的异常会存储到future；post投递的任务没有future，异常只能记录
+            try {
+                task();
+            } catch (const std::exception& e) {
+                PR_ERROR("ThreadPool task threw: %s", e.what());
+            } catch (...) {
+                PR_ERROR("ThreadPool task threw unknown exception");
+            }
 
             tp_idle_count_.fetch_add(1, std::memory_order_acq_rel);
         }
@@ -5,7 +5,16 @@
 #include <numeric>
 #include <cassert>
 #include "ThreadPool.hpp"
+#include "MpscQueue.hpp"
+#include "EventLoop.hpp"
+#include "Channel.hpp"
+#include "Epoll.hpp"
+#include "TcpConnection.hpp"
 #include <iomanip>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 void test_basic_functionality() {
     std::cout << "测试1: 基本功能测试..." << std::endl;
@@ -284,6 +293,371 @@ void test_destructor_with_pending_tasks() {
     std::cout << "析构函数正确处理未完成任务" << std::endl;
 }
 
+void test_task_type() {
+    std::cout << "\n测试11: 任务类型测试..." << std::endl;
+
+    // 常见捕获（shared_ptr + std::string）放在内部缓冲区，不分配堆内存
+    auto owner = std::make_shared<int>(7);
+    std::string msg(100, 'x');
+    auto common = [owner, msg]() { (void)msg; };
+    static_assert(Task::stores_inline<decltype(common)>(), "common capture should be stored inline");
+
+    // 只可移动的捕获
+    int result = 0;
+    auto ptr = std::make_unique<int>(42);
+    Task move_only([p = std::move(ptr), &result]() { result = *p; });
+    Task moved = std::move(move_only);
+    assert(!move_only && moved);
+    moved();
+    assert(result == 42);
+
+    // 超出内部缓冲区的捕获退化为堆分配，行为不变
+    struct Big { char data[256]; };
+    Big big{};
+    big.data[255] = 9;
+    auto large = [big, &result]() { result = big.data[255]; };
+    static_assert(!Task::stores_inline<decltype(large)>(), "large capture should use heap");
+    Task heap_task(large);
+    Task heap_moved = std::move(heap_task);
+    heap_moved();
+    assert(result == 9);
+
+    // 捕获对象随任务销毁而析构
+    long refs = owner.use_count();
+    {
+        Task holder([owner]() {});
+        assert(owner.use_count() == refs + 1);
+    }
+    assert(owner.use_count() == refs);
+
+    // ThreadPool::post：不需要future的投递
+    ThreadPool pool(2);
+    std::atomic<int> counter{0};
+    for (int i = 0; i < 100; ++i) {
+        pool.post([&counter]() { counter.fetch_add(1); });
+    }
+    pool.post([]() { throw std::runtime_error("post任务异常不应终止线程池"); });
+    pool.stop();
+    assert(counter.load() == 100);
+    std::cout << "任务类型测试通过" << std::endl;
+}
+
+void test_mpsc_queue() {
+    std::cout << "\n测试12: 无锁MPSC队列压力测试..." << std::endl;
+    constexpr uint64_t producers = 4;
+    constexpr uint64_t per_producer = 200000;
+    MpscQueue<uint64_t> queue;
+
+    std::vector<std::thread> threads;
+    for (uint64_t p = 0; p < producers; ++p) {
+        threads.emplace_back([&queue, p]() {
+            for (uint64_t seq = 1; seq <= per_producer; ++seq) {
+                queue.push(p << 32 | seq);
+            }
+        });
+    }
+
+    // 单消费者与生产者并发弹出：每个生产者的元素必须按入队顺序、不重不漏地出现
+    std::vector<uint64_t> last(producers, 0);
+    uint64_t received = 0;
+    uint64_t value = 0;
+    while (received < producers * per_producer) {
+        if (!queue.pop(value)) {
+            std::this_thread::yield();
+            continue;
+        }
+        uint64_t p = value >> 32;
+        uint64_t seq = value & 0xffffffffu;
+        assert(p < producers);
+        assert(seq == last[p] + 1);
+        last[p] = seq;
+        ++received;
+    }
+    for (auto& t : threads) t.join();
+    assert(!queue.pop(value));
+    std::cout << "MPSC队列测试通过 (" << received << "个元素)" << std::endl;
+}
+
+void test_event_loop_wakeup() {
+    std::cout << "\n测试13: EventLoop跨线程投递与唤醒测试..." << std::endl;
+    constexpr int producers = 4;
+    constexpr int rounds = 500;
+    constexpr int per_round = 8;
+
+    EventLoop loop;
+    std::thread loop_thread([&loop]() { loop.loop(); });
+
+    // 以下状态只在loop线程中修改
+    std::vector<int> last(producers, 0);
+    bool in_order = true;
+    std::atomic<int> executed{0};
+
+    // 每轮生产者并发投递少量任务后loop回到epoll_wait空闲：丢失一次唤醒就会卡到poll超时（10秒）
+    for (int round = 0; round < rounds; ++round) {
+        std::vector<std::thread> threads;
+        for (int p = 0; p < producers; ++p) {
+            threads.emplace_back([&, p, round]() {
+                for (int i = 1; i <= per_round; ++i) {
+                    int seq = round * per_round + i;
+                    loop.queueInLoop([&, p, seq]() {
+                        if (seq != last[p] + 1) in_order = false;
+                        last[p] = seq;
+                        executed.fetch_add(1, std::memory_order_release);
+                    });
+                }
+            });
+        }
+        for (auto& t : threads) t.join();
+
+        int expected = (round + 1) * producers * per_round;
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(3);
+        while (executed.load(std::memory_order_acquire) < expected) {
+            if (std::chrono::steady_clock::now() > deadline) {
+                loop.stop();
+                loop_thread.join();
+                throw std::runtime_error("queueInLoop lost a wakeup");
+            }
+            std::this_thread::yield();
+        }
+    }
+
+    std::promise<bool> order;
+    loop.queueInLoop([&]() { order.set_value(in_order); });
+    bool ordered = order.get_future().get();
+    loop.stop();
+    loop_thread.join();
+    assert(ordered);
+    std::cout << "EventLoop唤醒测试通过 (" << executed.load() << "个任务)" << std::endl;
+}
+
+// fd在同一批事件中被关闭并以相同编号重新打开：旧fd的未决事件不能分发给新Channel
+void test_event_loop_stale_events() {
+    std::cout << "\n测试14: EventLoop过期事件丢弃测试..." << std::endl;
+    EventLoop loop;
+    int fds[2] = {::eventfd(1, EFD_NONBLOCK | EFD_CLOEXEC), ::eventfd(1, EFD_NONBLOCK | EFD_CLOEXEC)};
+    assert(fds[0] >= 0 && fds[1] >= 0);
+
+    std::shared_ptr<Channel> channels[2];
+    std::shared_ptr<Channel> replacement;
+    bool swapped = false;
+    bool batch_done = false;
+    bool stale_dispatched = false;
+    bool replacement_ok = false;
+
+    auto drain = [](int fd) {
+        uint64_t v;
+        while (::read(fd, &v, sizeof(v)) > 0) {
+        }
+    };
+
+    for (int i = 0; i < 2; ++i) {
+        channels[i] = std::make_shared<Channel>(&loop, fds[i]);
+        channels[i]->set_callback([&, i](uint32_t) {
+            if (swapped) {
+                stale_dispatched = true;
+                return;
+            }
+            swapped = true;
+            drain(fds[i]);
+
+            // 两个fd在同一批中都就绪：先分发到的一方关闭另一方，并把一个新的就绪fd放到同一个编号上
+            int other = fds[1 - i];
+            channels[1 - i]->disable_all();
+            int fresh = ::eventfd(1, EFD_NONBLOCK | EFD_CLOEXEC);
+            assert(fresh >= 0);
+            assert(::dup2(fresh, other) == other);
+            ::close(fresh);
+
+            replacement = std::make_shared<Channel>(&loop, other);
+            replacement->set_callback([&, other](uint32_t) {
+                drain(other);
+                replacement_ok = batch_done;  // 只能在下一轮（本批结束之后）被分发
+                replacement->disable_all();
+                loop.stop();
+            });
+            replacement->enable_read();
+            loop.queueInLoop([&]() { batch_done = true; });
+        });
+    }
+
+    std::thread loop_thread([&]() {
+        channels[0]->enable_read();
+        channels[1]->enable_read();
+        loop.loop();
+    });
+    auto watchdog = std::async(std::launch::async, [&loop]() {
+        std::this_thread::sleep_for(std::chrono::seconds(3));
+        loop.stop();
+    });
+    loop_thread.join();
+
+    assert(swapped);
+    assert(!stale_dispatched);
+    assert(replacement_ok);
+    channels[0]->disable_all();
+    ::close(fds[0]);
+    ::close(fds[1]);
+    watchdog.wait();
+    std::cout << "EventLoop过期事件丢弃测试通过" << std::endl;
+}
+
+// 已注册的fd开启或关闭EPOLLEXCLUSIVE：内核不允许经MOD增减该标志，Epoll须按新旧掩码改用DEL+ADD
+void test_epoll_exclusive_toggle() {
+    std::cout << "\n测试15: EPOLLEXCLUSIVE切换测试..." << std::endl;
+    EventLoop loop;
+    Epoll epoller;
+    int efd = ::eventfd(1, EFD_NONBLOCK | EFD_CLOEXEC);
+    assert(efd >= 0);
+
+    auto ch = std::make_shared<Channel>(&loop, efd);
+    ch->set_exclusive(true);
+    ch->enable_read();
+    const uint64_t key = 42;
+    assert(epoller.add(ch.get(), key));
+
+    std::vector<epoll_event> active(4);
+    for (bool exclusive : {false, true, false}) {
+        uint32_t old_events = ch->epoll_events();
+        ch->set_exclusive(exclusive);
+        assert(epoller.mod(ch.get(), key, old_events));
+        assert(epoller.poll(0, active) == 1);
+        assert(active[0].data.u64 == key && (active[0].events & EPOLLIN));
+    }
+
+    ch->disable_all();
+    ::close(efd);
+    std::cout << "EPOLLEXCLUSIVE切换测试通过" << std::endl;
+}
+
+// 边缘触发下同一轮内先禁用再启用读事件：已注册掩码未变，但仍须执行MOD让内核重新检查就绪状态
+void test_edge_reenable_read() {
+    std::cout << "\n测试16: 边缘触发重新启用读事件测试..." << std::endl;
+    EventLoop loop;
+    int efd = ::eventfd(1, EFD_NONBLOCK | EFD_CLOEXEC);
+    assert(efd >= 0);
+
+    int dispatched = 0;
+    auto ch = std::make_shared<Channel>(&loop, efd);
+    ch->set_trigger_mode(TriggerMode::kEdge);
+    ch->set_callback([&](uint32_t) {
+        // 不读取数据：fd保持可读，不会再有新的边沿
+        if (++dispatched == 1) {
+            ch->disable_read();
+            ch->enable_read();
+        } else {
+            ch->disable_all();
+            loop.stop();
+        }
+    });
+
+    std::thread loop_thread([&]() {
+        // 同时关注写事件，使禁用读事件后掩码不为0（否则会走注销+重新注册，无法覆盖MOD路径）
+        ch->enable_write();
+        ch->enable_read();
+        loop.loop();
+    });
+    auto watchdog = std::async(std::launch::async, [&loop]() {
+        std::this_thread::sleep_for(std::chrono::seconds(3));
+        loop.stop();
+    });
+    loop_thread.join();
+
+    assert(dispatched == 2);
+    ch->disable_all();
+    ::close(efd);
+    watchdog.wait();
+    std::cout << "边缘触发重新启用读事件测试通过" << std::endl;
+}
+
+// 高/低水位与写完成回调：对端不读时越过高水位只通知一次；对端读空后依次通知低水位与写完成，之后再次越过高水位重新通知
+void test_tcp_connection_water_marks() {
+    std::cout << "\n测试17: TcpConnection水位回调测试..." << std::endl;
+    EventLoop loop;
+    std::thread loop_thread([&loop]() { loop.loop(); });
+
+    int fds[2];
+    assert(::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+    ::fcntl(fds[0], F_SETFL, O_NONBLOCK);
+    int sndbuf = 4096;
+    ::setsockopt(fds[0], SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf));
+
+    const size_t high_mark = 256 * 1024;
+    const size_t low_mark = 64 * 1024;
+    const size_t piece = 128 * 1024;
+    const int pieces = 8;
+    std::atomic<int> high_count{0};
+    std::atomic<int> low_count{0};
+    std::atomic<int> complete_count{0};
+    std::atomic<size_t> low_remaining{0};
+
+    // 在loop线程中执行并等待完成（此前由queueInLoop投递的回调先于它执行）
+    // 用queueInLoop而不是runInLoop：loop线程刚启动时thread_id_可能尚未更新，runInLoop会在本线程内直接执行
+    auto run_in_loop = [&loop](std::function<void()> fn) {
+        std::promise<void> done;
+        loop.queueInLoop([&]() {
+            fn();
+            done.set_value();
+        });
+        done.get_future().wait();
+    };
+    auto wait_for = [](const std::atomic<int>& counter, int expected) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(3);
+        while (counter.load() < expected && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return counter.load() == expected;
+    };
+
+    sockaddr_in peer{};
+    auto conn = std::make_shared<TcpConnection>(nullptr, &loop, fds[0], peer, sizeof(peer));
+    conn->set_high_water_mark_cb([&](TcpConnection::Ptr, size_t pending) {
+        assert(pending >= high_mark);
+        high_count.fetch_add(1);
+    }, high_mark);
+    conn->set_low_water_mark_cb([&](TcpConnection::Ptr, size_t remaining) {
+        low_remaining.store(remaining);
+        low_count.fetch_add(1);
+    }, low_mark);
+    conn->set_write_complete_cb([&](TcpConnection::Ptr) { complete_count.fetch_add(1); });
+    run_in_loop([&]() { conn->connect_established(); });
+
+    std::string payload(piece, 'w');
+    std::vector<char> sink(64 * 1024);
+    for (int round = 1; round <= 2; ++round) {
+        // 对端不读：多次追加越过高水位，只通知一次
+        run_in_loop([&]() {
+            for (int i = 0; i < pieces; ++i) {
+                assert(conn->send(payload));
+            }
+            assert(conn->output_buffer_length() >= high_mark);
+        });
+        run_in_loop([]() {});
+        assert(high_count.load() == round);
+        assert(low_count.load() == round - 1);
+        assert(complete_count.load() == round - 1);
+
+        // 对端读空：回落到低水位时通知一次，全部写入内核后通知写完成
+        size_t received = 0;
+        while (received < piece * pieces) {
+            ssize_t n = ::read(fds[1], sink.data(), sink.size());
+            assert(n > 0);
+            received += static_cast<size_t>(n);
+        }
+        assert(wait_for(complete_count, round));
+        assert(low_count.load() == round);
+        assert(low_remaining.load() <= low_mark);
+        assert(high_count.load() == round);
+    }
+
+    conn->force_close();
+    run_in_loop([]() {});
+    assert(!conn->is_connected());
+    loop.stop();
+    loop_thread.join();
+    ::close(fds[1]);
+    std::cout << "TcpConnection水位回调测试通过" << std::endl;
+}
+
 int main() {
     try {
         std::cout << "=== 线程池测试开始 ===" << std::endl;
@@ -296,6 +670,13 @@ int main() {
         test_idle_counter();
         test_complex_computation();
         test_destructor_with_pending_tasks();
+        test_task_type();
+        test_mpsc_queue();
+        test_event_loop_wakeup();
+        test_event_loop_stale_events();
+        test_epoll_exclusive_toggle();
+        test_edge_reenable_read();
+        test_tcp_connection_water_marks();
         
         std::cout << "\n=== 所有测试通过 ===" << std::endl;
         return 0;
@@ -115,29 +115,59 @@ void Timer::timer_loop() {
             continue;
         }
         
-        // 如果需要重新调度（周期性任务或重复任务还有剩余次数）
-        if (task.is_periodic || (task.is_repeat && task.repeat_count > 1)) {
-            // 创建下一次执行的任务
-            TimerTask next_task = task;
-            next_task.expire_time = now + task.interval;
-            
-            if (task.is_repeat) {
-                next_task.repeat_count--;
-            }
-            
-            // 重新加入队列
-            task_queue_.push(std::move(next_task));
-            condition_.notify_one();
-        }
-        
         // 释放锁，避免执行任务时阻塞定时器
         lock.unlock();
         
         // 在线程池中执行任务
+        // 周期/重复任务：状态随任务移入线程池，执行结束后才重新加入队列（各次执行串行，回调原地调用，不拷贝）
         try {
-            thread_pool_->post_task(std::move(task.callback));
+            if (task.repeat) {
+                auto next_expire = now + task.repeat->interval;
+                auto run = [this, id = task.task_id, repeat = std::move(task.repeat), next_expire]() mutable {
+                    run_repeat(id, std::move(repeat), next_expire);
+                };
+                static_assert(Task::stores_inline<decltype(run)>(), "repeat dispatch should not allocate");
+                thread_pool_->post(std::move(run));
+            } else {
+                thread_pool_->post(std::move(task.callback));
+            }
         } catch (const std::exception& e) {
             std::cerr << "Failed to post timer task: " << e.what() << std::endl;
         }
     }
-}
\ No newline at end of file
+}
+
+void Timer::run_repeat(int task_id, std::unique_ptr<RepeatState> repeat,
+                       std::chrono::steady_clock::time_point next_expire) {
+    // 重复任务：本次是最后一次时执行完即结束
+    bool again = repeat->is_periodic || --repeat->remaining > 0;
+    if (!again) {
+        repeat->callback();
+        return;
+    }
+    
+    // 回调抛出异常也要保留后续执行（异常继续交给线程池记录）
+    try {
+        repeat->callback();
+    } catch (...) {
+        rearm(task_id, std::move(repeat), next_expire);
+        throw;
+    }
+    rearm(task_id, std::move(repeat), next_expire);
+}
+
+void Timer::rearm(int task_id, std::unique_ptr<RepeatState> repeat,
+                  std::chrono::steady_clock::time_point expire_time) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (should_stop_.load()) {
+        return;
+    }
+    
+    // 执行耗时超过间隔时expire_time已过，下一次立即执行
+    TimerTask next_task;
+    next_task.expire_time = expire_time;
+    next_task.repeat = std::move(repeat);
+    next_task.task_id = task_id;
+    task_queue_.push(std::move(next_task));
+    condition_.notify_one();
+}
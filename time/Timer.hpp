@@ -18,17 +18,25 @@
  */
 class Timer {
 public:
+    /**
+     * @brief 周期/重复任务的状态（调度时分配一次，之后在队列与执行中的任务之间移动，不再拷贝）
+     * @note 同一任务的各次执行串行：本次执行结束后才重新加入队列，回调不会并发执行，其内部状态在各次执行间延续
+     */
+    struct RepeatState {
+        Task callback;                       ///< 回调函数（各次执行原地调用）
+        std::chrono::milliseconds interval;  ///< 执行间隔
+        int remaining;                       ///< 重复任务剩余执行次数（含即将执行的这一次）
+        bool is_periodic;                    ///< 是否为周期性任务（不限次数）
+    };
+
     /**
      * @brief 定时器任务结构
      */
     struct TimerTask {
         std::chrono::steady_clock::time_point expire_time;  ///< 过期时间
-        std::function<void()> callback;                     ///< 回调函数
+        Task callback;                                      ///< 回调函数（单次任务）
+        std::unique_ptr<RepeatState> repeat;                ///< 周期/重复任务的状态（单次任务为空）
         int task_id;                                        ///< 任务ID
-        int repeat_count;                                   ///< 剩余重复次数
-        std::chrono::milliseconds interval;                 ///< 执行间隔
-        bool is_periodic;                                   ///< 是否为周期性任务
-        bool is_repeat;                                     ///< 是否为重复任务
         
         bool operator<(const TimerTask& other) const {
             // 最小堆：过期时间早的优先级高
@@ -132,6 +140,21 @@ private:
      */
     void add_task(TimerTask task);
     
+    /**
+     * @brief 在线程池中执行一次周期/重复任务，还有后续执行时结束后重新加入队列
+     * @param task_id 任务ID
+     * @param repeat 任务状态
+     * @param next_expire 下一次执行的时间（按本次到期时刻加间隔计算）
+     */
+    void run_repeat(int task_id, std::unique_ptr<RepeatState> repeat,
+                    std::chrono::steady_clock::time_point next_expire);
+    
+    /**
+     * @brief 把执行完的周期/重复任务重新加入队列（定时器停止后直接丢弃）
+     */
+    void rearm(int task_id, std::unique_ptr<RepeatState> repeat,
+               std::chrono::steady_clock::time_point expire_time);
+    
     /**
      * @brief 生成唯一任务ID
      * @return 任务ID
@@ -162,13 +185,10 @@ int Timer::schedule_once(int delay_ms, F&& func, Args&&... args) {
     task.expire_time = std::chrono::steady_clock::now() + 
                        std::chrono::milliseconds(delay_ms);
     task.callback = std::bind(std::forward<F>(func), std::forward<Args>(args)...);
-    task.is_periodic = false;
-    task.is_repeat = false;
-    task.interval = std::chrono::milliseconds(delay_ms);
-    task.repeat_count = 0;
     
+    int task_id = task.task_id;
     add_task(std::move(task));
-    return task.task_id;
+    return task_id;
 }
 
 template <typename F, typename... Args>
@@ -181,14 +201,15 @@ int Timer::schedule_periodic(int interval_ms, F&& func, Args&&... args) {
     task.task_id = generate_task_id();
     task.expire_time = std::chrono::steady_clock::now() + 
                        std::chrono::milliseconds(interval_ms);
-    task.callback = std::bind(std::forward<F>(func), std::forward<Args>(args)...);
-    task.is_periodic = true;
-    task.is_repeat = false;
-    task.interval = std::chrono::milliseconds(interval_ms);
-    task.repeat_count = 0;
+    task.repeat = std::make_unique<RepeatState>();
+    task.repeat->callback = std::bind(std::forward<F>(func), std::forward<Args>(args)...);
+    task.repeat->interval = std::chrono::milliseconds(interval_ms);
+    task.repeat->remaining = 0;
+    task.repeat->is_periodic = true;
     
+    int task_id = task.task_id;
     add_task(std::move(task));
-    return task.task_id;
+    return task_id;
 }
 
 template <typename F, typename... Args>
@@ -201,14 +222,15 @@ int Timer::schedule_repeat(int interval_ms, int repeat_count, F&& func, Args&&..
     task.task_id = generate_task_id();
     task.expire_time = std::chrono::steady_clock::now() + 
                        std::chrono::milliseconds(interval_ms);
-    task.callback = std::bind(std::forward<F>(func), std::forward<Args>(args)...);
-    task.is_periodic = false;
-    task.is_repeat = true;
-    task.interval = std::chrono::milliseconds(interval_ms);
-    task.repeat_count = repeat_count;
+    task.repeat = std::make_unique<RepeatState>();
+    task.repeat->callback = std::bind(std::forward<F>(func), std::forward<Args>(args)...);
+    task.repeat->interval = std::chrono::milliseconds(interval_ms);
+    task.repeat->remaining = repeat_count;
+    task.repeat->is_periodic = false;
     
+    int task_id = task.task_id;
     add_task(std::move(task));
-    return task.task_id;
+    return task_id;
 }
 
 #endif // TIMER_HPP
\ No newline at end of file
@@ -4,6 +4,8 @@
 #include <atomic>
 #include <cassert>
 #include <cmath>
+#include <mutex>
+#include <vector>
 
 void test_basic_timer() {
     std::cout << "测试1: 基础定时器功能..." << std::endl;
@@ -172,6 +174,42 @@ void test_timer_resilience() {
     std::cout << "定时器健壮性测试通过" << std::endl;
 }
 
+void test_repeat_runs_serialized() {
+    std::cout << "\n测试7: 重复任务各次执行串行..." << std::endl;
+    
+    Timer timer(4);
+    assert(timer.start());
+    
+    std::mutex seen_mutex;
+    std::vector<int> seen;
+    std::atomic<int> running{0};
+    std::atomic<bool> overlapped{false};
+    
+    // 每次执行耗时大于间隔：下一次执行要等本次结束后才会开始，
+    // 回调是同一个对象（原地调用，不拷贝），mutable状态在各次执行间延续
+    int task_id = timer.schedule_repeat(10, 4, [&, calls = 0]() mutable {
+        if (running.fetch_add(1) != 0) overlapped.store(true);
+        ++calls;
+        {
+            std::lock_guard<std::mutex> lock(seen_mutex);
+            seen.push_back(calls);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(30));
+        running.fetch_sub(1);
+    });
+    
+    assert(task_id >= 0);
+    
+    std::this_thread::sleep_for(std::chrono::milliseconds(250));
+    
+    timer.stop();
+    
+    assert(!overlapped.load());
+    std::lock_guard<std::mutex> lock(seen_mutex);
+    assert((seen == std::vector<int>{1, 2, 3, 4}));
+    std::cout << "重复任务各次执行串行测试通过" << std::endl;
+}
+
 int main() {
     try {
         std::cout << "=== 定时器测试开始 ===" << std::endl;
@@ -182,6 +220,7 @@ int main() {
         test_cancel_timer();
         test_concurrent_timers();
         test_timer_resilience();
+        test_repeat_runs_serialized();
         
         std::cout << "\n=== 所有测试通过 ===" << std::endl;
         return 0;